@@ -567,6 +567,9 @@ public HResult GetDacSignatureVerificationSettings(out bool value)
             public readonly delegate* unmanaged[Stdcall]<IntPtr, void> FlushCheck;
             public readonly delegate* unmanaged[Stdcall]<IntPtr, byte*, IntPtr, int> ExecuteHostCommand;
             public readonly delegate* unmanaged[Stdcall]<IntPtr, int*, int> GetDacSignatureVerificationSettings;
+            public readonly delegate* unmanaged[Stdcall]<IntPtr, uint> GetStopId;
+            public readonly delegate* unmanaged[Stdcall]<IntPtr, void*, int> GetMemoryReadStatistics;
+            public readonly delegate* unmanaged[Stdcall]<IntPtr, void*, uint, int> ReadVirtualBatch;
         }
     }
 }
@@ -19,7 +19,9 @@ DbgEngServices::DbgEngServices(IDebugClient* client) :
     m_system(nullptr),
     m_advanced(nullptr),
     m_settings(nullptr),
-    m_targetMachine(nullptr)
+    m_targetMachine(nullptr),
+    m_flushNeeded(false),
+    m_stopId(0)
 {
     client->AddRef();
 }
@@ -269,6 +271,33 @@ DbgEngServices::ReadVirtual(
     return m_data->ReadVirtual(offset, buffer, bufferSize, bytesRead);
 }
 
+HRESULT
+DbgEngServices::ReadVirtualBatch(
+    PREAD_VIRTUAL_REQUEST requests,
+    ULONG count)
+{
+    if (requests == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+    // dbgeng has its own memory cache so there isn't anything to gain from merging
+    HRESULT result = S_OK;
+    for (ULONG i = 0; i < count; i++)
+    {
+        ULONG bytesRead = 0;
+        if (FAILED(m_data->ReadVirtual(requests[i].offset, requests[i].buffer, requests[i].bufferSize, &bytesRead)))
+        {
+            bytesRead = 0;
+        }
+        requests[i].bytesRead = bytesRead;
+        if (bytesRead < requests[i].bufferSize)
+        {
+            result = S_FALSE;
+        }
+    }
+    return result;
+}
+
 HRESULT 
 DbgEngServices::WriteVirtual(
     ULONG64 offset,
@@ -610,6 +639,7 @@ DbgEngServices::FlushCheck()
     if (m_flushNeeded)
     {
         m_flushNeeded = false;
+        m_stopId++;
         Extensions::GetInstance()->FlushTarget();
     }
 }
@@ -653,6 +683,20 @@ DbgEngServices::GetDacSignatureVerificationSettings(
     return S_OK;
 }
 
+ULONG
+DbgEngServices::GetStopId()
+{
+    return m_stopId;
+}
+
+HRESULT
+DbgEngServices::GetMemoryReadStatistics(
+    PMEMORY_READ_STATISTICS statistics)
+{
+    // dbgeng does its own memory caching and doesn't keep these counters
+    return E_NOTIMPL;
+}
+
 //----------------------------------------------------------------------------
 // IRemoteMemoryService
 //----------------------------------------------------------------------------
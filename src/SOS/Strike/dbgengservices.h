@@ -32,6 +32,7 @@ private:
     IModelObject*         m_settings;
     IMachine*             m_targetMachine;
     bool                  m_flushNeeded;
+    ULONG                 m_stopId;
 
 public:
     DbgEngServices(IDebugClient* client);
@@ -237,6 +238,15 @@ public:
     HRESULT STDMETHODCALLTYPE GetDacSignatureVerificationSettings(
         BOOL* dacSignatureVerificationEnabled);
 
+    ULONG STDMETHODCALLTYPE GetStopId();
+
+    HRESULT STDMETHODCALLTYPE GetMemoryReadStatistics(
+        PMEMORY_READ_STATISTICS statistics);
+
+    HRESULT STDMETHODCALLTYPE ReadVirtualBatch(
+        PREAD_VIRTUAL_REQUEST requests,
+        ULONG count);
+
     //----------------------------------------------------------------------------
     // IRemoteMemoryService
     //----------------------------------------------------------------------------
@@ -888,7 +888,7 @@ BOOL PrintCallInfo(DWORD_PTR vEBP, DWORD_PTR IP, DumpStackFlag& DSFlag, BOOL bSy
         // TODO: Microsoft, more checks to make sure method is not eeimpl, etc. Add this field to MethodDesc
         
         DacpCodeHeaderData codeHeaderData;
-        if (codeHeaderData.Request(g_sos, TO_CDADDR(IP)) == S_OK)
+        if (RequestCodeHeaderData(TO_CDADDR(IP), &codeHeaderData) == S_OK)
         {
             DWORD_PTR IPBegin = (DWORD_PTR) codeHeaderData.MethodStart;        
             methodDesc = (DWORD_PTR) codeHeaderData.MethodDescPtr;
@@ -17,6 +17,12 @@ const int nSegLookupStgIncrement = 100;
 
 #define CCH_STRING_PREFIX_SUMMARY 64
 
+// Number of characters in each block of interned HeapStat strings
+#define HEAPSTAT_STRING_BLOCK_SIZE 0x8000
+
+// Number of MethodTableCache entries allocated together
+#define MTCACHE_ENTRY_BLOCK_SIZE 256
+
 /**********************************************************************\
 * Routine Description:                                                 *
 *                                                                      *
@@ -25,240 +31,160 @@ const int nSegLookupStgIncrement = 100;
 \**********************************************************************/
 void HeapStat::Add(DWORD_PTR aData, DWORD aSize)
 {
-    if (head == 0)
+    _ASSERTE(!fSorted);
+
+    // Keep the table at most 3/4 full
+    if ((count + 1) * 4 > capacity * 3)
     {
-        head = new Node();
-        if (head == NULL)
+        if (!Grow())
         {
             ReportOOM();
             ControlC = TRUE;
             return;
         }
+    }
 
-        if (bHasStrings)
+    ULONG hash = Hash(aData);
+    ULONG mask = capacity - 1;
+    for (ULONG i = hash & mask; ; i = (i + 1) & mask)
+    {
+        Entry& entry = entries[i];
+        if (entry.count == 0)
         {
-            size_t capacity_pNew = _wcslen((WCHAR*)aData) + 1;
-            WCHAR *pNew = new WCHAR[capacity_pNew];
-            if (pNew == NULL)
+            if (bHasStrings)
             {
-               ReportOOM();
-               ControlC = TRUE;
-               return;
+                aData = (DWORD_PTR)InternString((WCHAR*)aData);
+                if (aData == 0)
+                {
+                    ReportOOM();
+                    ControlC = TRUE;
+                    return;
+                }
             }
-            wcscpy_s(pNew, capacity_pNew, (WCHAR*)aData);
-            aData = (DWORD_PTR)pNew;
-        }
-
-        head->data = aData;
-    }
-    Node *walk = head;
-    int cmp = 0;
-
-    for (;;)
-    {
-        if (IsInterrupt())
+            entry.data = aData;
+            entry.hash = hash;
+            entry.count = 1;
+            entry.totalSize = aSize;
+            count++;
             return;
-
-        cmp = CompareData(aData, walk->data);
-
-        if (cmp == 0)
-            break;
-
-        if (cmp < 0)
-        {
-            if (walk->left == NULL)
-                break;
-            walk = walk->left;
         }
-        else
+        if (entry.hash == hash && (bHasStrings ? _wcscmp((WCHAR*)entry.data, (WCHAR*)aData) == 0 : entry.data == aData))
         {
-            if (walk->right == NULL)
-                break;
-            walk = walk->right;
+            entry.count++;
+            entry.totalSize += aSize;
+            return;
         }
     }
+}
 
-    if (cmp == 0)
-    {
-        walk->count ++;
-        walk->totalSize += aSize;
-    }
-    else
+ULONG HeapStat::Hash(DWORD_PTR aData)
+{
+    if (bHasStrings)
     {
-        Node *node = new Node();
-        if (node == NULL)
-        {
-            ReportOOM();
-            ControlC = TRUE;
-            return;
-        }
-
-        if (bHasStrings)
+        // FNV-1a
+        ULONG hash = 2166136261u;
+        for (const WCHAR* str = (const WCHAR*)aData; *str != W('\0'); str++)
         {
-            size_t capacity_pNew = _wcslen((WCHAR*)aData) + 1;
-            WCHAR *pNew = new WCHAR[capacity_pNew];
-            if (pNew == NULL)
-            {
-               ReportOOM();
-               ControlC = TRUE;
-               return;
-            }
-            wcscpy_s(pNew, capacity_pNew, (WCHAR*)aData);
-            aData = (DWORD_PTR)pNew;
-        }
-
-        node->data = aData;
-        node->totalSize = aSize;
-        node->count ++;
-
-        if (cmp < 0)
-        {
-            walk->left = node;
-        }
-        else
-        {
-            walk->right = node;
+            hash = (hash ^ *str) * 16777619u;
         }
+        return hash;
     }
-}
-/**********************************************************************\
-* Routine Description:                                                 *
-*                                                                      *
-*    This function compares two nodes in the tree.     *
-*                                                                      *
-\**********************************************************************/
-int HeapStat::CompareData(DWORD_PTR d1, DWORD_PTR d2)
-{
-    if (bHasStrings)
-        return _wcscmp((WCHAR*)d1, (WCHAR*)d2);
-
-    if (d1 > d2)
-        return 1;
-
-    if (d1 < d2)
-        return -1;
-
-    return 0;
+    // MethodTables are pointer aligned so mix the upper bits down
+    return (ULONG)(((ULONG64)aData * 0x9E3779B97F4A7C15ull) >> 32);
 }
 
-/**********************************************************************\
-* Routine Description:                                                 *
-*                                                                      *
-*    This function is called to sort all entries in the heap stat.     *
-*                                                                      *
-\**********************************************************************/
-void HeapStat::Sort ()
+BOOL HeapStat::Grow()
 {
-    Node *root = head;
-    head = NULL;
-    ReverseLeftMost (root);
-
-    Node *sortRoot = NULL;
-    while (head)
-    {
-        Node *tmp = head;
-        head = head->left;
-        if (tmp->right)
-            ReverseLeftMost (tmp->right);
-        // add tmp
-        tmp->right = NULL;
-        tmp->left = NULL;
-        SortAdd (sortRoot, tmp);
-    }
-    head = sortRoot;
+    ULONG newCapacity = capacity == 0 ? 64 : capacity * 2;
+    if (newCapacity < capacity)
+        return FALSE;
 
-    Linearize();
+    Entry* newEntries = new (std::nothrow) Entry[newCapacity];
+    if (newEntries == NULL)
+        return FALSE;
 
-    //reverse the order
-    root = head;
-    head = NULL;
-    sortRoot = NULL;
-    while (root)
+    memset(newEntries, 0, newCapacity * sizeof(Entry));
+    ULONG mask = newCapacity - 1;
+    for (ULONG i = 0; i < capacity; i++)
     {
-        Node *tmp = root->right;
-        root->left = NULL;
-        root->right = NULL;
-        LinearAdd (sortRoot, root);
-        root = tmp;
+        if (entries[i].count != 0)
+        {
+            ULONG j = entries[i].hash & mask;
+            while (newEntries[j].count != 0)
+                j = (j + 1) & mask;
+            newEntries[j] = entries[i];
+        }
     }
-    head = sortRoot;
+    delete [] entries;
+    entries = newEntries;
+    capacity = newCapacity;
+    return TRUE;
 }
 
-void HeapStat::Linearize()
+WCHAR* HeapStat::InternString(const WCHAR* str)
 {
-    // Change binary tree to a linear tree
-    Node *root = head;
-    head = NULL;
-    ReverseLeftMost (root);
-    Node *sortRoot = NULL;
-    while (head)
+    size_t length = _wcslen(str) + 1;
+    if (strings == NULL || strings->capacity - strings->used < length)
     {
-        Node *tmp = head;
-        head = head->left;
-        if (tmp->right)
-            ReverseLeftMost (tmp->right);
-        // add tmp
-        tmp->right = NULL;
-        tmp->left = NULL;
-        LinearAdd (sortRoot, tmp);
-    }
-    head = sortRoot;
-    fLinear = TRUE;
-}
+        size_t blockCapacity = _max(length, (size_t)HEAPSTAT_STRING_BLOCK_SIZE);
+        StringBlock* block = (StringBlock*)new (std::nothrow) BYTE[offsetof(StringBlock, data) + blockCapacity * sizeof(WCHAR)];
+        if (block == NULL)
+            return NULL;
 
-void HeapStat::ReverseLeftMost (Node *root)
-{
-    while (root)
-    {
-        Node *tmp = root->left;
-        root->left = head;
-        head = root;
-        root = tmp;
+        block->next = strings;
+        block->used = 0;
+        block->capacity = blockCapacity;
+        strings = block;
     }
+    WCHAR* result = strings->data + strings->used;
+    memcpy(result, str, length * sizeof(WCHAR));
+    strings->used += length;
+    return result;
 }
 
 /**********************************************************************\
 * Routine Description:                                                 *
 *                                                                      *
-*    This function is called to help to sort heap stat.                *
+*    This function is called to sort all entries in the heap stat by   *
+*    total size.                                                       *
 *                                                                      *
 \**********************************************************************/
-void HeapStat::SortAdd (Node *&root, Node *entry)
+void HeapStat::Sort ()
 {
-    if (root == NULL)
-    {
-        root = entry;
-    }
-    else
+    if (fSorted)
+        return;
+
+    // Pack the used slots at the start of the table and sort them once
+    ULONG used = 0;
+    for (ULONG i = 0; i < capacity; i++)
     {
-        Node *parent = root;
-        Node *ptr = root;
-        while (ptr)
-        {
-            parent = ptr;
-            if (ptr->totalSize < entry->totalSize)
-                ptr = ptr->right;
-            else
-                ptr = ptr->left;
-        }
-        if (parent->totalSize < entry->totalSize)
-            parent->right = entry;
-        else
-            parent->left = entry;
+        if (entries[i].count != 0)
+            entries[used++] = entries[i];
     }
+    _ASSERTE(used == count);
+    if (used > 1)
+        qsort(entries, used, sizeof(Entry), bHasStrings ? CompareStringEntries : CompareEntries);
+    fSorted = TRUE;
 }
 
-void HeapStat::LinearAdd(Node *&root, Node *entry)
+int __cdecl HeapStat::CompareEntries(const void* e1, const void* e2)
 {
-    if (root == NULL)
-    {
-        root = entry;
-    }
-    else
-    {
-        entry->right = root;
-        root = entry;
-    }
+    const Entry* entry1 = (const Entry*)e1;
+    const Entry* entry2 = (const Entry*)e2;
+    if (entry1->totalSize != entry2->totalSize)
+        return entry1->totalSize < entry2->totalSize ? -1 : 1;
+    if (entry1->data != entry2->data)
+        return entry1->data < entry2->data ? -1 : 1;
+    return 0;
+}
+
+int __cdecl HeapStat::CompareStringEntries(const void* e1, const void* e2)
+{
+    const Entry* entry1 = (const Entry*)e1;
+    const Entry* entry2 = (const Entry*)e2;
+    if (entry1->totalSize != entry2->totalSize)
+        return entry1->totalSize < entry2->totalSize ? -1 : 1;
+    return _wcscmp((WCHAR*)entry1->data, (WCHAR*)entry2->data);
 }
 
 /**********************************************************************\
@@ -279,62 +205,56 @@ void HeapStat::Print(const char* label /* = NULL */)
     else
         ExtOut("%" POINTERSIZE "s %8s %12s %s\n","MT", "Count", "TotalSize", "Class Name");
 
-    Node *root = head;
+    Sort();
+
     int ncount = 0;
-    while (root)
+    for (ULONG i = 0; i < count; i++)
     {
         if (IsInterrupt())
             return;
 
-        ncount += root->count;
+        const Entry& entry = entries[i];
+        ncount += entry.count;
 
         if (bHasStrings)
         {
-            ExtOut("%8d %12I64u \"%S\"\n", root->count, (unsigned __int64)root->totalSize, root->data);
+            ExtOut("%8d %12I64u \"%S\"\n", entry.count, (unsigned __int64)entry.totalSize, entry.data);
         }
         else
         {
-            DMLOut("%s %8d %12I64u ", DMLDumpHeapMT(root->data), root->count, (unsigned __int64)root->totalSize);
-            if (IsMTForFreeObj(root->data))
+            DMLOut("%s %8d %12I64u ", DMLDumpHeapMT(entry.data), entry.count, (unsigned __int64)entry.totalSize);
+            if (IsMTForFreeObj(entry.data))
             {
                 ExtOut("%9s\n", "Free");
             }
             else
             {
                 wcscpy_s(g_mdName, mdNameLen, W("UNKNOWN"));
-                NameForMT_s((DWORD_PTR) root->data, g_mdName, mdNameLen);
+                NameForMT_s((DWORD_PTR) entry.data, g_mdName, mdNameLen);
                 ExtOut("%S\n", g_mdName);
             }
         }
-        root = root->right;
-
     }
     ExtOut ("Total %d objects\n", ncount);
 }
 
 void HeapStat::Delete()
 {
-    if (head == NULL)
-        return;
-
-    // Ensure the data structure is already linearized.
-    if (!fLinear)
-        Linearize();
+    delete [] entries;
+    entries = NULL;
+    capacity = 0;
+    count = 0;
 
-    while (head)
+    while (strings != NULL)
     {
-        // The list is linearized on such that the left node is always null.
-        Node *tmp = head;
-        head = head->right;
-
-        if (bHasStrings)
-            delete[] ((WCHAR*)tmp->data);
-        delete tmp;
+        StringBlock* next = strings->next;
+        delete [] (BYTE*)strings;
+        strings = next;
     }
 
     // return to default state
     bHasStrings = FALSE;
-    fLinear = FALSE;
+    fSorted = FALSE;
 }
 
 // -----------------------------------------------------------------------
@@ -345,80 +265,103 @@ void HeapStat::Delete()
 //
 MethodTableInfo* MethodTableCache::Lookup (DWORD_PTR aData)
 {
-    Node** addHere = &head;
-    if (head != 0) {
-        Node *walk = head;
-        int cmp = 0;
-
-        for (;;)
+    // Keep the table at most 3/4 full
+    if ((count + 1) * 4 > capacity * 3)
+    {
+        if (!Grow())
         {
-            cmp = CompareData(aData, walk->data);
-
-            if (cmp == 0)
-                return &walk->info;
+            ReportOOM();
+            return NULL;
+        }
+    }
 
-            if (cmp < 0)
-            {
-                if (walk->left == NULL)
-                {
-                    addHere = &walk->left;
-                    break;
-                }
-                walk = walk->left;
-            }
-            else
+    ULONG mask = capacity - 1;
+    for (ULONG i = Hash(aData) & mask; ; i = (i + 1) & mask)
+    {
+        Slot& slot = table[i];
+        if (slot.entry == NULL)
+        {
+            Entry* entry = AllocateEntry(aData);
+            if (entry == NULL)
             {
-                if (walk->right == NULL)
-                {
-                    addHere = &walk->right;
-                    break;
-                }
-                walk = walk->right;
+                ReportOOM();
+                return NULL;
             }
+            slot.data = aData;
+            slot.entry = entry;
+            count++;
+            return &entry->info;
         }
+        if (slot.data == aData)
+            return &slot.entry->info;
     }
-    Node* newNode = new Node(aData);
-    if (newNode == NULL)
-    {
-        ReportOOM();
-        return NULL;
-    }
-    *addHere = newNode;
-    return &newNode->info;
 }
 
-/**********************************************************************\
-* Routine Description:                                                 *
-*                                                                      *
-*    This function compares two nodes in the tree.     *
-*                                                                      *
-\**********************************************************************/
-int MethodTableCache::CompareData(DWORD_PTR d1, DWORD_PTR d2)
+ULONG MethodTableCache::Hash(DWORD_PTR aData)
 {
-    if (d1 > d2)
-        return 1;
+    // MethodTables are pointer aligned so mix the upper bits down
+    return (ULONG)(((ULONG64)aData * 0x9E3779B97F4A7C15ull) >> 32);
+}
 
-    if (d1 < d2)
-        return -1;
+BOOL MethodTableCache::Grow()
+{
+    ULONG newCapacity = capacity == 0 ? 256 : capacity * 2;
+    if (newCapacity < capacity)
+        return FALSE;
 
-    return 0;
+    Slot* newTable = new (std::nothrow) Slot[newCapacity];
+    if (newTable == NULL)
+        return FALSE;
+
+    memset(newTable, 0, newCapacity * sizeof(Slot));
+    ULONG mask = newCapacity - 1;
+    for (ULONG i = 0; i < capacity; i++)
+    {
+        if (table[i].entry != NULL)
+        {
+            ULONG j = Hash(table[i].data) & mask;
+            while (newTable[j].entry != NULL)
+                j = (j + 1) & mask;
+            newTable[j] = table[i];
+        }
+    }
+    delete [] table;
+    table = newTable;
+    capacity = newCapacity;
+    return TRUE;
 }
 
-void MethodTableCache::ReverseLeftMost (Node *root)
+MethodTableCache::Entry* MethodTableCache::AllocateEntry(DWORD_PTR aData)
 {
-    if (root)
+    if (entryBlocks == NULL || entryBlocks->used == MTCACHE_ENTRY_BLOCK_SIZE)
     {
-        if (root->left) ReverseLeftMost(root->left);
-        if (root->right) ReverseLeftMost(root->right);
-        delete root;
+        EntryBlock* block = (EntryBlock*)new (std::nothrow) BYTE[offsetof(EntryBlock, entries) + MTCACHE_ENTRY_BLOCK_SIZE * sizeof(Entry)];
+        if (block == NULL)
+            return NULL;
+
+        block->next = entryBlocks;
+        block->used = 0;
+        entryBlocks = block;
     }
+    Entry* entry = &entryBlocks->entries[entryBlocks->used++];
+    memset(entry, 0, sizeof(Entry));
+    entry->data = aData;
+    return entry;
 }
 
 void MethodTableCache::Clear()
 {
-    Node *root = head;
-    head = NULL;
-    ReverseLeftMost (root);
+    delete [] table;
+    table = NULL;
+    capacity = 0;
+    count = 0;
+
+    while (entryBlocks != NULL)
+    {
+        EntryBlock* next = entryBlocks->next;
+        delete [] (BYTE*)entryBlocks;
+        entryBlocks = next;
+    }
 }
 
 MethodTableCache g_special_mtCache;
@@ -457,6 +400,9 @@ static MethodTableInfo* GetMethodTableInfo(DWORD_PTR dwAddrMethTable)
     // Remove lower bits in case we are in mark phase
     dwAddrMethTable = dwAddrMethTable & ~sos::Object::METHODTABLE_PTR_LOW_BITMASK;
     MethodTableInfo* info = g_special_mtCache.Lookup(dwAddrMethTable);
+    if (info == NULL)
+        return NULL;
+
     if (!info->IsInitialized())        // An uninitialized entry
     {
         // this is the first time we see this method table, so we need to get the information
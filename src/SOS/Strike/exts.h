@@ -33,6 +33,7 @@
 #ifndef FEATURE_PAL
 #include "dbgengservices.h"
 #endif
+#include "debuggerservices.h"
 
 #include "platformspecific.h"
 
@@ -192,17 +193,49 @@ inline BOOL IsInterrupt()
 #define DECLARE_API(extension)     \
 CPPMOD HRESULT CALLBACK extension(PDEBUG_CLIENT client, PCSTR args)
 
+// Memory read counters kept in all builds for every command and displayed by "sosstatus -perf".
+struct PerfCounters
+{
+    ULONG64 readCalls;              // reads SOS sent to the debugger
+    ULONG64 bytesRead;
+    ULONG64 failedReads;
+    ULONG64 cacheReads;             // reads through the SOS read caches
+    ULONG64 cacheHits;              // cache reads that didn't need a debugger read
+    ULONG64 dacTargetReads;         // reads the DAC made through the SOS data targets (not DAC requests)
+    ULONG64 debuggerReadCalls;      // all the reads the debugger serviced (lldb only)
+    ULONG64 debuggerBytesRead;
+    ULONG64 debuggerFailedReads;
+    ULONG64 elapsedMicroseconds;
+};
+
+// The counters of the command currently running
+extern PerfCounters g_perfCounters;
+
+inline void PerfCountRead(HRESULT hr, ULONG bytesRead)
+{
+    g_perfCounters.readCalls++;
+    g_perfCounters.bytesRead += bytesRead;
+    if (FAILED(hr))
+    {
+        g_perfCounters.failedReads++;
+    }
+}
+
+void PerfBeginCommand(const char* name);
+void PerfEndCommand();
+void DisplayPerfCounters();
+
 class __ExtensionCleanUp
 {
 public:
-    __ExtensionCleanUp(){}
-    ~__ExtensionCleanUp(){ExtRelease();}
+    __ExtensionCleanUp(const char* name){PerfBeginCommand(name);}
+    ~__ExtensionCleanUp(){PerfEndCommand(); ExtRelease();}
 };
 
 // The minimum initialization for a command
 #define INIT_API_EXT()                                          \
     HRESULT Status;                                             \
-    __ExtensionCleanUp __extensionCleanUp;                      \
+    __ExtensionCleanUp __extensionCleanUp(__FUNCTION__);        \
     if ((Status = ExtInit(client)) != S_OK) return Status;
 
 // Also initializes the target machine
@@ -237,8 +270,9 @@ public:
         return Status;                                          \
     }                                                           \
     g_bDacBroken = FALSE;                                       \
-    /* If LoadClrDebugDll() succeeded make sure we release g_clrData. */  \
-    /* We may reconsider caching g_clrData in the future */     \
+    /* If LoadClrDebugDll() succeeded make sure we release this */  \
+    /* command's references. The DAC instance and its caches are */  \
+    /* kept until the target moves (see FlushSOSCaches). */     \
     ToRelease<IXCLRDataProcess> spIDP(g_clrData);               \
     ToRelease<ISOSDacInterface> spISD(g_sos);                   \
     ToRelease<ISOSDacInterface15> spISD15(g_sos15);             \
@@ -275,8 +309,8 @@ public:
         g_bDacBroken = FALSE;                                   \
         ResetGlobals();                                         \
     }                                                           \
-    /* If LoadClrDebugDll() succeeded make sure we release g_clrData. */  \
-    /* We may reconsider caching g_clrData in the future */     \
+    /* If LoadClrDebugDll() succeeded make sure we release this */  \
+    /* command's references. */                                 \
     ToRelease<IXCLRDataProcess> spIDP(g_clrData);               \
     ToRelease<ISOSDacInterface> spISD(g_sos);                   \
     ToRelease<ISOSDacInterface15> spISD15(g_sos15);             \
@@ -462,17 +496,67 @@ extern WINDBG_EXTENSION_APIS ExtensionApis;
 #endif // FEATURE_PAL
 
 #define CACHE_SIZE  DT_OS_PAGE_SIZE
- 
-struct ReadVirtualCache
+
+// The default number of CACHE_SIZE pages kept by the ReadVirtualCache (1MB). This
+// can be overridden with the DOTNET_SOS_ReadCachePages environment variable up to
+// CACHE_MAX_PAGES (256MB); the page indexes and hash bucket count must fit in an int.
+#define CACHE_DEFAULT_PAGES 256
+#define CACHE_MAX_PAGES     0x10000
+
+// Page-aligned LRU cache of target memory used by MOVE, MOVEBLOCK and GetMTOfObject.
+// Commands like DumpObj or DumpMT bounce between object headers, MethodTables and
+// EEClass data, so several hot pages are kept instead of a single window. Pages are
+// found through a small chained hash table and evicted least recently used first.
+class ReadVirtualCache
 {
-    BYTE   m_cache[CACHE_SIZE];
-    TADDR  m_startCache;
-    BOOL   m_cacheValid;
-    ULONG  m_cacheSize;
-
-    ReadVirtualCache() { Clear(); }
-    HRESULT Read(TADDR Offset, PVOID Buffer, ULONG BufferSize, PULONG lpcbBytesRead);    
-    void Clear() { m_cacheValid = FALSE; m_cacheSize = CACHE_SIZE; }
+public:
+    ReadVirtualCache(ULONG maxPages = CACHE_DEFAULT_PAGES);
+    ~ReadVirtualCache();
+
+    HRESULT Read(TADDR Offset, PVOID Buffer, ULONG BufferSize, PULONG lpcbBytesRead);
+
+    // Reads the pages covering [address, address + size) of each address that aren't
+    // already cached in as few debugger calls as possible.
+    void Prefetch(const TADDR* addresses, ULONG count, ULONG size);
+
+    // Discards all the cached pages
+    void Clear();
+
+    // Changes the number of pages the cache can hold (clamped to CACHE_MAX_PAGES). Discards the cached pages.
+    void SetMaxPages(ULONG maxPages);
+    ULONG GetMaxPages() const { return m_maxPages; }
+
+private:
+    struct Page
+    {
+        TADDR start;            // Page aligned target address (the key)
+        ULONG size;             // Number of bytes that could be read from the target
+        int   hashNext;         // Next page in the same hash bucket or -1
+        int   lruPrev;          // Previous (more recently used) page or -1
+        int   lruNext;          // Next (less recently used) page or -1
+        BYTE  data[CACHE_SIZE];
+    };
+
+    bool EnsureAllocated();
+    void Free();
+    ULONG Bucket(TADDR start) const;
+    int FindPage(TADDR start, ULONG bucket) const;
+    int AllocatePage();
+    bool CommitPage(int index, TADDR start, ULONG bucket, ULONG cbBytesRead);
+    Page* GetPage(TADDR start);
+    void FillPages(PREAD_VIRTUAL_REQUEST requests, const int* indexes, ULONG count);
+    HRESULT UncachedRead(TADDR address, PVOID buffer, ULONG bufferSize, PULONG lpcbBytesRead);
+    void Unlink(int index);
+    void LinkAtHead(int index);
+    void RemoveFromBucket(int index);
+
+    Page* m_pages;
+    int*  m_buckets;
+    ULONG m_maxPages;
+    ULONG m_bucketMask;
+    ULONG m_usedPages;
+    int   m_lruHead;
+    int   m_lruTail;
 };
 
 extern ReadVirtualCache *rvCache;
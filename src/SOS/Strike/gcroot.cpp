@@ -62,6 +62,7 @@ bool LinearReadCache::MoveToPage(TADDR addr, unsigned int size)
 
     mCurrPageStart = addr;
     HRESULT hr = g_ExtData->ReadVirtual(mCurrPageStart, mPage, size, &mCurrPageSize);
+    PerfCountRead(hr, mCurrPageSize);
 
     if (hr != S_OK)
     {
@@ -70,9 +71,7 @@ bool LinearReadCache::MoveToPage(TADDR addr, unsigned int size)
         return false;
     }
 
-#ifdef _DEBUG
     mMisses++;
-#endif
     return true;
 }
 
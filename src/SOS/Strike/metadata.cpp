@@ -8,6 +8,9 @@
 // ==--==
 #include "strike.h"
 #include "util.h"
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 /**********************************************************************\
 * Routine Description:                                                 *
@@ -62,6 +65,80 @@ static HRESULT NameForTypeDef_s(mdTypeDef tkTypeDef, IMetaDataImport *pImport,
     return hr;
 }
 
+//---------------------------------------------------------------------------------------
+//
+// The metadata importers and formatted token names are kept for the current cache epoch
+// (see FlushSOSCaches). Commands that print many fields or methods of the same types
+// would otherwise redo the same DAC and metadata work for each of them.
+//
+enum TokenNameKind
+{
+    TokenName,
+    TokenNameWithClass,
+    MethodName,
+};
+
+struct TokenNameKey
+{
+    IMetaDataImport* pImport;
+    mdToken token;
+    TokenNameKind kind;
+
+    bool operator==(const TokenNameKey& other) const
+    {
+        return pImport == other.pImport && token == other.token && kind == other.kind;
+    }
+};
+
+struct TokenNameKeyHash
+{
+    size_t operator()(const TokenNameKey& key) const
+    {
+        ULONG64 hash = ((ULONG64)(size_t)key.pImport ^ ((ULONG64)key.token << 2) ^ key.kind) * 0x9E3779B97F4A7C15ull;
+        return (size_t)(hash >> 32);
+    }
+};
+
+static std::unordered_map<TADDR, IMetaDataImport*> s_mdImports;     // NULL if the module has no importer
+static std::unordered_set<IMetaDataImport*> s_cachedImports;
+static std::unordered_map<TokenNameKey, std::basic_string<WCHAR>, TokenNameKeyHash> s_tokenNames;
+
+void FlushMetadataCache()
+{
+    for (auto& entry : s_mdImports)
+    {
+        if (entry.second != NULL)
+        {
+            entry.second->Release();
+        }
+    }
+    s_mdImports.clear();
+    s_cachedImports.clear();
+    s_tokenNames.clear();
+}
+
+// Returns the name memoized for the token or NULL. The names are only kept for the
+// importers in the cache because those stay alive until the cache is flushed.
+static const std::basic_string<WCHAR>* FindTokenName(IMetaDataImport* pImport, mdToken token, TokenNameKind kind)
+{
+    if (pImport == NULL || s_cachedImports.find(pImport) == s_cachedImports.end())
+    {
+        return NULL;
+    }
+    TokenNameKey key = { pImport, token, kind };
+    auto found = s_tokenNames.find(key);
+    return found != s_tokenNames.end() ? &found->second : NULL;
+}
+
+static void AddTokenName(IMetaDataImport* pImport, mdToken token, TokenNameKind kind, LPCWSTR name)
+{
+    if (pImport != NULL && s_cachedImports.find(pImport) != s_cachedImports.end())
+    {
+        TokenNameKey key = { pImport, token, kind };
+        s_tokenNames[key] = name;
+    }
+}
+
 /**********************************************************************\
 * Routine Description:                                                 *
 *                                                                      *
@@ -70,6 +147,16 @@ static HRESULT NameForTypeDef_s(mdTypeDef tkTypeDef, IMetaDataImport *pImport,
 \**********************************************************************/
 IMetaDataImport* MDImportForModule(DacpModuleData* pModule)
 {
+    auto found = s_mdImports.find(TO_TADDR(pModule->Address));
+    if (found != s_mdImports.end())
+    {
+        if (found->second != NULL)
+        {
+            found->second->AddRef();
+        }
+        return found->second;
+    }
+
     IMetaDataImport *pRet = NULL;
     ToRelease<IXCLRDataModule> module;
     HRESULT hr = g_sos->GetModule(pModule->Address, &module);
@@ -77,14 +164,31 @@ IMetaDataImport* MDImportForModule(DacpModuleData* pModule)
     if (SUCCEEDED(hr))
         hr = module->QueryInterface(IID_IMetaDataImport, (LPVOID *) &pRet);
 
-    if (SUCCEEDED(hr))
-        return pRet;
+    if (FAILED(hr))
+        pRet = NULL;
 
-    return NULL;
+    // The cache keeps its own reference
+    if (pRet != NULL)
+    {
+        pRet->AddRef();
+        s_cachedImports.insert(pRet);
+    }
+    s_mdImports[TO_TADDR(pModule->Address)] = pRet;
+    return pRet;
 }
 
 IMetaDataImport* MDImportForModule(DWORD_PTR pModule)
 {
+    auto found = s_mdImports.find(TO_TADDR(pModule));
+    if (found != s_mdImports.end())
+    {
+        if (found->second != NULL)
+        {
+            found->second->AddRef();
+        }
+        return found->second;
+    }
+
     DacpModuleData moduleData;
     if(moduleData.Request(g_sos, TO_CDADDR(pModule))==S_OK)
         return MDImportForModule(&moduleData);
@@ -110,6 +214,14 @@ HRESULT NameForToken_s(mdTypeDef mb, IMetaDataImport *pImport, __out_ecount (cap
         return E_FAIL;
     }
 
+    TokenNameKind kind = bClassName ? TokenNameWithClass : TokenName;
+    const std::basic_string<WCHAR>* cachedName = FindTokenName(pImport, mb, kind);
+    if (cachedName != NULL && cachedName->length() < capacity_mdName)
+    {
+        wcscpy_s(mdName, capacity_mdName, cachedName->c_str());
+        return S_OK;
+    }
+
     HRESULT hr = E_FAIL;
 
     PAL_CPP_TRY
@@ -167,6 +279,12 @@ HRESULT NameForToken_s(mdTypeDef mb, IMetaDataImport *pImport, __out_ecount (cap
             hr = E_FAIL;
     }
     PAL_CPP_ENDTRY
+
+    // Don't remember names that may have been truncated
+    if (SUCCEEDED(hr) && _wcslen(mdName) + 1 < capacity_mdName)
+    {
+        AddTokenName(pImport, mb, kind, mdName);
+    }
     return hr;
 }
 
@@ -393,6 +511,13 @@ void MDInfo::GetMethodName(mdMethodDef token, CQuickBytes *fullName)
     m_pSigBuf = fullName;
     InitSigBuffer();
 
+    const std::basic_string<WCHAR>* cachedName = FindTokenName(m_pImport, token, MethodName);
+    if (cachedName != NULL)
+    {
+        AddToSigBuffer(cachedName->c_str());
+        return;
+    }
+
     WCHAR szFunctionName[1024];
 
     if (m_pImport != NULL)
@@ -436,6 +561,8 @@ void MDInfo::GetMethodName(mdMethodDef token, CQuickBytes *fullName)
 
     if (FAILED(hr))
         ExtOut("ERROR!! Bad signature blob value!");
+    else if (lSigBlobRemaining == 0)
+        AddTokenName(m_pImport, token, MethodName, (LPCWSTR)m_pSigBuf->Ptr());
 }
 
 
@@ -118,6 +118,7 @@ public:
             return E_UNEXPECTED;
         }
         address = CONVERT_FROM_SIGN_EXTENDED(address);
+        g_perfCounters.dacTargetReads++;
 #ifdef FEATURE_PAL
         if (g_sos != nullptr)
         {
@@ -134,7 +135,13 @@ public:
             }
         }
 #endif
-        HRESULT hr = g_ExtData->ReadVirtual(address, pBuffer, request, (PULONG) pcbRead);
+        ULONG bytesRead = 0;
+        HRESULT hr = g_ExtData->ReadVirtual(address, pBuffer, request, &bytesRead);
+        PerfCountRead(hr, bytesRead);
+        if (pcbRead != nullptr)
+        {
+            *pcbRead = bytesRead;
+        }
         if (FAILED(hr)) 
         {
             ExtDbgOut("CorDebugDataTarget::ReadVirtual FAILED %08x address %p size %08x\n", hr, address, request);
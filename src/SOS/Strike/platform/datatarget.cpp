@@ -155,6 +155,7 @@ DataTarget::ReadVirtual(
         return E_UNEXPECTED;
     }
     address = CONVERT_FROM_SIGN_EXTENDED(address);
+    g_perfCounters.dacTargetReads++;
 #ifdef FEATURE_PAL
     if (g_sos != nullptr)
     {
@@ -171,7 +172,13 @@ DataTarget::ReadVirtual(
         }
     }
 #endif
-    HRESULT hr = g_ExtData->ReadVirtual(address, (PVOID)buffer, request, (PULONG)done);
+    ULONG bytesRead = 0;
+    HRESULT hr = g_ExtData->ReadVirtual(address, (PVOID)buffer, request, &bytesRead);
+    PerfCountRead(hr, bytesRead);
+    if (done != nullptr)
+    {
+        *done = bytesRead;
+    }
     if (FAILED(hr)) 
     {
         ExtDbgOut("DataTarget::ReadVirtual FAILED %08x address %08llx size %08x\n", hr, address, request);
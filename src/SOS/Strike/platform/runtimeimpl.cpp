@@ -4,6 +4,8 @@
 #include "strike.h"
 #include "util.h"
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include <corhdr.h>
 #include <cor.h>
 #include <clrdata.h>
@@ -61,12 +63,118 @@ extern "C" bool TryGetSymbolWithCallback(
     const char* symbolName,
     ULONG64* symbolAddress);
 
+extern "C" bool TryGetBuildIdWithCallback(
+    bool (*readMemory)(void* address, void* buffer, size_t size),
+    ULONG64 baseAddress,
+    BYTE* buffer,
+    ULONG bufferSize,
+    PULONG pBuildSize);
+
+extern "C" void* CreateSymbolIndexWithCallback(
+    bool (*readMemory)(void* address, void* buffer, size_t size),
+    ULONG64 baseAddress);
+
+extern "C" int TryGetSymbolsFromIndex(
+    void* symbolIndex,
+    int count,
+    const char* const* symbolNames,
+    ULONG64* symbolAddresses);
+
+extern "C" void DestroySymbolIndex(void* symbolIndex);
+
 bool ReaderReadMemory(void* address, void* buffer, size_t size)
 {
     ULONG read = 0;
     return SUCCEEDED(g_ExtData->ReadVirtual((ULONG64)address, buffer, (ULONG)size, &read));
 }
 
+#define MAX_SYMBOL_INDEX_BUILDID_SIZE 64
+
+struct SymbolIndexEntry
+{
+    ULONG BuildIdSize;
+    BYTE BuildId[MAX_SYMBOL_INDEX_BUILDID_SIZE];
+    ULONG StopId;
+    void* SymbolIndex;
+};
+
+// Parsed ELF/Mach-O export tables keyed by module base address (validated with the build id)
+static std::unordered_map<ULONG64, SymbolIndexEntry> g_symbolIndexes;
+
+/**********************************************************************\
+ * Frees the cached module symbol indexes
+\**********************************************************************/
+void FlushSymbolIndexes()
+{
+    for (const auto& entry : g_symbolIndexes)
+    {
+        ::DestroySymbolIndex(entry.second.SymbolIndex);
+    }
+    g_symbolIndexes.clear();
+}
+
+/**********************************************************************\
+ * Resolves an export of the ELF or Mach-O module at the base address.
+ * The parsed symbol tables are kept per (module base, build id) so the
+ * single-file runtime probe of every module (repeated on each command
+ * while no runtime is found) and the runtime's own export lookups don't
+ * re-parse the headers and hash tables every time. The build id is only
+ * re-read to validate a cached index once per debugger stop.
+\**********************************************************************/
+static bool TryGetModuleSymbol(ULONG64 baseAddress, const char* symbolName, ULONG64* symbolAddress)
+{
+    IDebuggerServices* debuggerServices = GetDebuggerServices();
+    ULONG stopId = debuggerServices != nullptr ? debuggerServices->GetStopId() : 0;
+
+    auto it = g_symbolIndexes.find(baseAddress);
+    if (it != g_symbolIndexes.end() && debuggerServices != nullptr && it->second.StopId == stopId)
+    {
+        // Already validated since the target last ran
+        return ::TryGetSymbolsFromIndex(it->second.SymbolIndex, 1, &symbolName, symbolAddress) == 1;
+    }
+
+    BYTE buildId[MAX_SYMBOL_INDEX_BUILDID_SIZE];
+    ULONG buildIdSize = 0;
+    bool hasBuildId = ::TryGetBuildIdWithCallback(ReaderReadMemory, baseAddress, buildId, sizeof(buildId), &buildIdSize) &&
+        buildIdSize > 0 && buildIdSize <= sizeof(buildId);
+
+    void* symbolIndex = nullptr;
+    if (it != g_symbolIndexes.end())
+    {
+        SymbolIndexEntry& entry = it->second;
+        if (hasBuildId && entry.BuildIdSize == buildIdSize && memcmp(entry.BuildId, buildId, buildIdSize) == 0)
+        {
+            entry.StopId = stopId;
+            symbolIndex = entry.SymbolIndex;
+        }
+        else
+        {
+            // A different module is now loaded at this address
+            ::DestroySymbolIndex(entry.SymbolIndex);
+            g_symbolIndexes.erase(it);
+        }
+    }
+    if (!hasBuildId)
+    {
+        // Without a build id there is nothing to validate a cached index against
+        return ::TryGetSymbolWithCallback(ReaderReadMemory, baseAddress, symbolName, symbolAddress);
+    }
+    if (symbolIndex == nullptr)
+    {
+        symbolIndex = ::CreateSymbolIndexWithCallback(ReaderReadMemory, baseAddress);
+        if (symbolIndex == nullptr)
+        {
+            return ::TryGetSymbolWithCallback(ReaderReadMemory, baseAddress, symbolName, symbolAddress);
+        }
+        SymbolIndexEntry& entry = g_symbolIndexes[baseAddress];
+        entry.BuildIdSize = buildIdSize;
+        memcpy(entry.BuildId, buildId, buildIdSize);
+        entry.StopId = stopId;
+        entry.SymbolIndex = symbolIndex;
+    }
+    return ::TryGetSymbolsFromIndex(symbolIndex, 1, &symbolName, symbolAddress) == 1;
+}
+
 /**********************************************************************\
  * Search all the modules in the process for the single-file host
 \**********************************************************************/
@@ -100,7 +208,7 @@ static HRESULT GetSingleFileInfo(ITarget* target, PULONG pModuleIndex, PULONG64
         if (target->GetOperatingSystem() == ITarget::OperatingSystem::Linux ||
             target->GetOperatingSystem() == ITarget::OperatingSystem::OSX)
         {
-            if (!::TryGetSymbolWithCallback(ReaderReadMemory, baseAddress, symbolName, &symbolAddress)) {
+            if (!TryGetModuleSymbol(baseAddress, symbolName, &symbolAddress)) {
                 continue;
             }
         }
@@ -629,7 +737,7 @@ ULONG64 Runtime::GetContractDescriptorAddress()
     if (m_target->GetOperatingSystem() == ITarget::OperatingSystem::Linux ||
         m_target->GetOperatingSystem() == ITarget::OperatingSystem::OSX)
     {
-        if (!::TryGetSymbolWithCallback(ReaderReadMemory, m_address, symbolName, &symbolAddress))
+        if (!TryGetModuleSymbol(m_address, symbolName, &symbolAddress))
         {
             return 0;
         }
@@ -44,6 +44,9 @@
 
 extern IRuntime* g_pRuntime;
 
+// Frees the cached ELF/Mach-O module symbol indexes
+extern void FlushSymbolIndexes();
+
 // Returns the runtime configuration as a string
 inline static const char* GetRuntimeConfigurationName(IRuntime::RuntimeConfiguration config)
 {
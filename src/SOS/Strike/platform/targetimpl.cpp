@@ -68,6 +68,7 @@ Target::~Target()
         m_desktop = nullptr;
     }
 #endif
+    FlushSymbolIndexes();
     g_pRuntime = nullptr;
     s_target = nullptr;
 }
@@ -2053,6 +2053,13 @@ HRESULT PrintArray(DacpObjectData& objData, DumpArrayFlags& flags, BOOL isPermSe
         indices[0] = (DWORD)flags.startIndex;
     }
 
+    // The reference elements are read a block at a time instead of one pointer per debugger
+    // call. With -details the objects they point to are prefetched as a group too.
+    const size_t ElementBlockCount = 64;
+    TADDR elementBlock[ElementBlockCount];
+    size_t elementBlockStart = 0;
+    size_t elementBlockCount = 0;
+
     //Offset should be calculated by OffsetFromIndices. However because of the way
     //how we grow indices, incrementing offset by one happens to match indices in every iteration
     for (size_t offset = OffsetFromIndices (indices, lowerBounds, bounds, objData.dwRank);
@@ -2067,10 +2074,31 @@ HRESULT PrintArray(DacpObjectData& objData, DumpArrayFlags& flags, BOOL isPermSe
 
         TADDR elementAddress = TO_TADDR(objData.ArrayDataPtr + offset * objData.dwComponentSize);
         TADDR p_Element = (TADDR)0;
+        if (!isElementValueType && objData.dwComponentSize == sizeof(TADDR) &&
+            (offset < elementBlockStart || offset >= elementBlockStart + elementBlockCount))
+        {
+            size_t count = _min(ElementBlockCount, (size_t)objData.dwNumComponents - _min(offset, (size_t)objData.dwNumComponents));
+            ULONG bytesRead = 0;
+            elementBlockStart = offset;
+            elementBlockCount = 0;
+            if (count > 0 && SafeReadMemory(elementAddress, elementBlock, (ULONG)(count * sizeof(TADDR)), &bytesRead))
+            {
+                elementBlockCount = bytesRead / sizeof(TADDR);
+                if (flags.bDetail)
+                {
+                    rvCache->Prefetch(elementBlock, (ULONG)elementBlockCount, sizeof(TADDR));
+                }
+            }
+        }
+
         if (isElementValueType)
         {
             p_Element = elementAddress;
         }
+        else if (offset >= elementBlockStart && offset < elementBlockStart + elementBlockCount)
+        {
+            p_Element = elementBlock[offset - elementBlockStart];
+        }
         else if (!SafeReadMemory (elementAddress, &p_Element, sizeof (p_Element), NULL))
         {
             ExtOut("Failed to read element at ");
@@ -4961,13 +4989,14 @@ DECLARE_API(WatsonBuckets)
 
 struct PendingBreakpoint
 {
-    WCHAR szModuleName[MAX_LONGPATH];
-    WCHAR szFunctionName[mdNameLen];
-    WCHAR szFilename[MAX_LONGPATH];
+    LPWSTR szModuleName;        // Interned by Breakpoints, never NULL
+    LPWSTR szFunctionName;
+    LPWSTR szFilename;
     DWORD lineNumber;
     TADDR pModule;
     DWORD ilOffset;
     mdMethodDef methodToken;
+    ULONG keyHash;              // Hash of the lookup key, see Breakpoints::KeyHash
     void SetModule(TADDR module)
     {
         pModule = module;
@@ -4978,20 +5007,97 @@ struct PendingBreakpoint
         return (compare == pModule);
     }
 
-    PendingBreakpoint *pNext;
-    PendingBreakpoint() : lineNumber(0), ilOffset(0), methodToken(0), pNext(NULL)
+    PendingBreakpoint *pNext;           // List of all the pending breakpoints, newest first
+    PendingBreakpoint *pPrev;
+    PendingBreakpoint *pNextKey;        // Chain in the key index
+    PendingBreakpoint *pNextModule;     // Chain in the module index
+    PendingBreakpoint() : lineNumber(0), pModule(0), ilOffset(0), methodToken(0), keyHash(0),
+        pNext(NULL), pPrev(NULL), pNextKey(NULL), pNextModule(NULL)
     {
-        szModuleName[0] = L'\0';
-        szFunctionName[0] = L'\0';
-        szFilename[0] = L'\0';
+        szModuleName = szFunctionName = szFilename = NULL;
+    }
+};
+
+// The set of addresses a debugger breakpoint has already been placed on
+class PlacedBreakpoints
+{
+    CLRDATA_ADDRESS* m_addresses;       // Open addressing, 0 marks an empty slot
+    ULONG m_capacity;
+    ULONG m_count;
+
+    static ULONG Hash(CLRDATA_ADDRESS addr)
+    {
+        return (ULONG)(((ULONG64)addr * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    BOOL Grow()
+    {
+        ULONG newCapacity = m_capacity == 0 ? 256 : m_capacity * 2;
+        if (newCapacity < m_capacity)
+            return FALSE;
+
+        CLRDATA_ADDRESS* newAddresses = new NOTHROW CLRDATA_ADDRESS[newCapacity];
+        if (newAddresses == NULL)
+            return FALSE;
+
+        memset(newAddresses, 0, newCapacity * sizeof(CLRDATA_ADDRESS));
+        ULONG mask = newCapacity - 1;
+        for (ULONG i = 0; i < m_capacity; i++)
+        {
+            if (m_addresses[i] != 0)
+            {
+                ULONG j = Hash(m_addresses[i]) & mask;
+                while (newAddresses[j] != 0)
+                    j = (j + 1) & mask;
+                newAddresses[j] = m_addresses[i];
+            }
+        }
+        delete [] m_addresses;
+        m_addresses = newAddresses;
+        m_capacity = newCapacity;
+        return TRUE;
+    }
+
+public:
+    PlacedBreakpoints() : m_addresses(NULL), m_capacity(0), m_count(0)
+    {
+    }
+
+    ~PlacedBreakpoints()
+    {
+        delete [] m_addresses;
+    }
+
+    // Returns TRUE if the address wasn't already in the set. If the set can't
+    // grow, new addresses are considered unique.
+    BOOL Add(CLRDATA_ADDRESS addr)
+    {
+        if (addr == 0)
+            return TRUE;
+
+        // Keep the table at most 3/4 full
+        if ((m_count + 1) * 4 > m_capacity * 3 && !Grow())
+            return TRUE;
+
+        ULONG mask = m_capacity - 1;
+        for (ULONG i = Hash(addr) & mask; ; i = (i + 1) & mask)
+        {
+            if (m_addresses[i] == addr)
+                return FALSE;
+
+            if (m_addresses[i] == 0)
+            {
+                m_addresses[i] = addr;
+                m_count++;
+                return TRUE;
+            }
+        }
     }
 };
 
 void IssueDebuggerBPCommand ( CLRDATA_ADDRESS addr )
 {
-    const int MaxBPsCached = 1024;
-    static CLRDATA_ADDRESS alreadyPlacedBPs[MaxBPsCached];
-    static int curLimit = 0;
+    static PlacedBreakpoints alreadyPlacedBPs;
 
     // on ARM the debugger requires breakpoint addresses to be sanitized
     if (IsDbgTargetArm())
@@ -5001,21 +5107,7 @@ void IssueDebuggerBPCommand ( CLRDATA_ADDRESS addr )
       addr |= THUMB_CODE; // lldb expects thumb code bit set
 #endif
 
-    // if we overflowed our cache consider all new BPs unique...
-    BOOL bUnique = curLimit >= MaxBPsCached;
-    if (!bUnique)
-    {
-        bUnique = TRUE;
-        for (int i = 0; i < curLimit; ++i)
-        {
-            if (alreadyPlacedBPs[i] == addr)
-            {
-                bUnique = FALSE;
-                break;
-            }
-        }
-    }
-    if (bUnique)
+    if (alreadyPlacedBPs.Add(addr))
     {
         char buffer[64]; // sufficient for "bp <pointersize>"
         static WCHAR wszNameBuffer[1024]; // should be large enough
@@ -5035,21 +5127,163 @@ void IssueDebuggerBPCommand ( CLRDATA_ADDRESS addr )
 #endif
         ExtOut("Setting breakpoint: %s [%S]\n", buffer, wszNameBuffer);
         g_ExtControl->Execute(DEBUG_OUTCTL_NOT_LOGGED, buffer, 0);
+    }
+}
+
+// Interned copies of the strings the pending breakpoints refer to. Equal strings
+// share one copy so the breakpoint indexes can compare them by pointer.
+class BreakpointStrings
+{
+    struct Entry
+    {
+        Entry* next;
+        ULONG hash;
+        WCHAR str[1];
+    };
 
-        if (curLimit < MaxBPsCached)
+    Entry** m_buckets;
+    ULONG m_bucketCount;        // Always a power of 2
+    ULONG m_count;
+    bool m_ignoreCase;
+
+    ULONG Hash(LPCWSTR str)
+    {
+        // FNV-1a, folding ASCII case when the strings compare case insensitively
+        ULONG hash = 2166136261u;
+        for (; *str != W('\0'); str++)
         {
-            alreadyPlacedBPs[curLimit++] = addr;
+            WCHAR ch = *str;
+            if (m_ignoreCase && ch >= W('A') && ch <= W('Z'))
+                ch += W('a') - W('A');
+            hash = (hash ^ ch) * 16777619u;
         }
+        return hash;
     }
-}
 
+    bool Equals(LPCWSTR str1, LPCWSTR str2)
+    {
+        return (m_ignoreCase ? _wcsicmp(str1, str2) : _wcscmp(str1, str2)) == 0;
+    }
+
+    BOOL Grow()
+    {
+        ULONG newBucketCount = m_bucketCount == 0 ? 64 : m_bucketCount * 2;
+        if (newBucketCount < m_bucketCount)
+            return FALSE;
+
+        Entry** newBuckets = new NOTHROW Entry*[newBucketCount];
+        if (newBuckets == NULL)
+            return FALSE;
+
+        memset(newBuckets, 0, newBucketCount * sizeof(Entry*));
+        for (ULONG i = 0; i < m_bucketCount; i++)
+        {
+            for (Entry* entry = m_buckets[i]; entry != NULL; )
+            {
+                Entry* next = entry->next;
+                Entry** bucket = &newBuckets[entry->hash & (newBucketCount - 1)];
+                entry->next = *bucket;
+                *bucket = entry;
+                entry = next;
+            }
+        }
+        delete [] m_buckets;
+        m_buckets = newBuckets;
+        m_bucketCount = newBucketCount;
+        return TRUE;
+    }
+
+public:
+    BreakpointStrings(bool ignoreCase) : m_buckets(NULL), m_bucketCount(0), m_count(0), m_ignoreCase(ignoreCase)
+    {
+    }
+
+    ~BreakpointStrings()
+    {
+        Clear();
+    }
+
+    // Returns the interned copy of the string or NULL if it hasn't been interned
+    LPWSTR Find(LPCWSTR str)
+    {
+        if (m_count == 0)
+            return NULL;
+
+        ULONG hash = Hash(str);
+        for (Entry* entry = m_buckets[hash & (m_bucketCount - 1)]; entry != NULL; entry = entry->next)
+        {
+            if (entry->hash == hash && Equals(entry->str, str))
+                return entry->str;
+        }
+        return NULL;
+    }
+
+    // Returns the interned copy of the string, adding it if needed. NULL if out of memory.
+    LPWSTR Intern(LPCWSTR str)
+    {
+        LPWSTR result = Find(str);
+        if (result != NULL)
+            return result;
+
+        if (m_count >= m_bucketCount && !Grow())
+            return NULL;
+
+        size_t length = _wcslen(str) + 1;
+        Entry* entry = (Entry*)new NOTHROW BYTE[offsetof(Entry, str) + length * sizeof(WCHAR)];
+        if (entry == NULL)
+            return NULL;
+
+        memcpy(entry->str, str, length * sizeof(WCHAR));
+        entry->hash = Hash(str);
+        Entry** bucket = &m_buckets[entry->hash & (m_bucketCount - 1)];
+        entry->next = *bucket;
+        *bucket = entry;
+        m_count++;
+        return entry->str;
+    }
+
+    void Clear()
+    {
+        for (ULONG i = 0; i < m_bucketCount; i++)
+        {
+            for (Entry* entry = m_buckets[i]; entry != NULL; )
+            {
+                Entry* next = entry->next;
+                delete [] (BYTE*)entry;
+                entry = next;
+            }
+        }
+        delete [] m_buckets;
+        m_buckets = NULL;
+        m_bucketCount = 0;
+        m_count = 0;
+    }
+};
+
+// The pending breakpoints are indexed two ways so that setting thousands of them and
+// binding them as modules load doesn't walk the whole list each time:
+//
+// - by key: (module, method token, IL offset) for breakpoints bound to a method,
+//   otherwise (module, module name, function name) or (module, file name, line).
+// - by module, so module load, JIT and unload notifications only visit the
+//   breakpoints for that module (or the unbound ones, which have module 0).
 class Breakpoints
 {
     PendingBreakpoint* m_breakpoints;
+    PendingBreakpoint** m_keyBuckets;
+    PendingBreakpoint** m_moduleBuckets;
+    ULONG m_bucketCount;        // Always a power of 2
+    ULONG m_count;
+    BreakpointStrings m_names;          // Module and file names, case insensitive
+    BreakpointStrings m_functionNames;
 public:
-    Breakpoints()
+    Breakpoints() : m_names(true), m_functionNames(false)
     {
         m_breakpoints = NULL;
+        m_keyBuckets = NULL;
+        m_moduleBuckets = NULL;
+        m_bucketCount = 0;
+        m_count = 0;
     }
     ~Breakpoints()
     {
@@ -5061,62 +5295,66 @@ public:
             pCur = pNext;
         }
         m_breakpoints = NULL;
+        delete [] m_keyBuckets;
+        delete [] m_moduleBuckets;
     }
 
-    void Add(__in_z LPWSTR szModule, __in_z LPWSTR szName, TADDR mod, DWORD ilOffset)
+    void Add(__in_z LPCWSTR szModule, __in_z LPCWSTR szName, TADDR mod, DWORD ilOffset)
     {
         if (!IsIn(szModule, szName, mod))
         {
-            PendingBreakpoint *pNew = new PendingBreakpoint();
-            wcscpy_s(pNew->szModuleName, MAX_LONGPATH, szModule);
-            wcscpy_s(pNew->szFunctionName, mdNameLen, szName);
-            pNew->SetModule(mod);
-            pNew->ilOffset = ilOffset;
-            pNew->pNext = m_breakpoints;
-            m_breakpoints = pNew;
+            PendingBreakpoint *pNew = Create(szModule, szName, NULL);
+            if (pNew != NULL)
+            {
+                pNew->SetModule(mod);
+                pNew->ilOffset = ilOffset;
+                Insert(pNew);
+            }
         }
     }
 
-    void Add(__in_z LPWSTR szModule, __in_z LPWSTR szName, mdMethodDef methodToken, TADDR mod, DWORD ilOffset)
+    void Add(__in_z LPCWSTR szModule, __in_z LPCWSTR szName, mdMethodDef methodToken, TADDR mod, DWORD ilOffset)
     {
         if (!IsIn(methodToken, mod, ilOffset))
         {
-            PendingBreakpoint *pNew = new PendingBreakpoint();
-            wcscpy_s(pNew->szModuleName, MAX_LONGPATH, szModule);
-            wcscpy_s(pNew->szFunctionName, mdNameLen, szName);
-            pNew->methodToken = methodToken;
-            pNew->SetModule(mod);
-            pNew->ilOffset = ilOffset;
-            pNew->pNext = m_breakpoints;
-            m_breakpoints = pNew;
+            PendingBreakpoint *pNew = Create(szModule, szName, NULL);
+            if (pNew != NULL)
+            {
+                pNew->methodToken = methodToken;
+                pNew->SetModule(mod);
+                pNew->ilOffset = ilOffset;
+                Insert(pNew);
+            }
         }
     }
 
-    void Add(__in_z LPWSTR szFilename, DWORD lineNumber, TADDR mod)
+    void Add(__in_z LPCWSTR szFilename, DWORD lineNumber, TADDR mod)
     {
         if (!IsIn(szFilename, lineNumber, mod))
         {
-            PendingBreakpoint *pNew = new PendingBreakpoint();
-            wcscpy_s(pNew->szFilename, MAX_LONGPATH, szFilename);
-            pNew->lineNumber = lineNumber;
-            pNew->SetModule(mod);
-            pNew->pNext = m_breakpoints;
-            m_breakpoints = pNew;
+            PendingBreakpoint *pNew = Create(NULL, NULL, szFilename);
+            if (pNew != NULL)
+            {
+                pNew->lineNumber = lineNumber;
+                pNew->SetModule(mod);
+                Insert(pNew);
+            }
         }
     }
 
-    void Add(__in_z LPWSTR szFilename, DWORD lineNumber, mdMethodDef methodToken, TADDR mod, DWORD ilOffset)
+    void Add(__in_z LPCWSTR szFilename, DWORD lineNumber, mdMethodDef methodToken, TADDR mod, DWORD ilOffset)
     {
         if (!IsIn(methodToken, mod, ilOffset))
         {
-            PendingBreakpoint *pNew = new PendingBreakpoint();
-            wcscpy_s(pNew->szFilename, MAX_LONGPATH, szFilename);
-            pNew->lineNumber = lineNumber;
-            pNew->methodToken = methodToken;
-            pNew->SetModule(mod);
-            pNew->ilOffset = ilOffset;
-            pNew->pNext = m_breakpoints;
-            m_breakpoints = pNew;
+            PendingBreakpoint *pNew = Create(NULL, NULL, szFilename);
+            if (pNew != NULL)
+            {
+                pNew->lineNumber = lineNumber;
+                pNew->methodToken = methodToken;
+                pNew->SetModule(mod);
+                pNew->ilOffset = ilOffset;
+                Insert(pNew);
+            }
         }
     }
 
@@ -5124,7 +5362,6 @@ public:
     BOOL Update(TADDR mod, BOOL isNewModule)
     {
         BOOL bNeedUpdates = FALSE;
-        PendingBreakpoint *pCur = NULL;
 
         if(isNewModule)
         {
@@ -5135,55 +5372,59 @@ public:
 
             // Get tokens for any modules that match. If there was a change,
             // update notifications.
-            pCur = m_breakpoints;
-            while(pCur)
-            {
-                PendingBreakpoint *pNext = pCur->pNext;
-                ResolvePendingNonModuleBoundBreakpoint(mod, pCur, pSymReader);
-                pCur = pNext;
-            }
+            ResolvePendingNonModuleBoundBreakpoints(mod, pSymReader);
         }
 
-        pCur = m_breakpoints;
-        while(pCur)
+        if (m_count == 0)
         {
-            PendingBreakpoint *pNext = pCur->pNext;
-            if (ResolvePendingBreakpoint(mod, pCur))
+            return FALSE;
+        }
+
+        ToRelease<IXCLRDataModule> pModule;
+        if (FAILED(g_sos->GetModule(mod, &pModule)))
+        {
+            return FALSE;
+        }
+
+        for (PendingBreakpoint *pCur = m_moduleBuckets[ModuleHash(mod) & (m_bucketCount - 1)]; pCur != NULL; pCur = pCur->pNextModule)
+        {
+            if (ResolvePendingBreakpoint(mod, pModule, pCur))
             {
                 bNeedUpdates = TRUE;
             }
-            pCur = pNext;
         }
         return bNeedUpdates;
     }
 
     BOOL UpdateKnownCodeAddress(TADDR mod, CLRDATA_ADDRESS bpLocation)
     {
-        PendingBreakpoint *pCur = m_breakpoints;
-        BOOL bpSet = FALSE;
+        if (m_count == 0)
+        {
+            return FALSE;
+        }
 
-        while(pCur)
+        for (PendingBreakpoint *pCur = m_moduleBuckets[ModuleHash(mod) & (m_bucketCount - 1)]; pCur != NULL; pCur = pCur->pNextModule)
         {
-            PendingBreakpoint *pNext = pCur->pNext;
             if (pCur->ModuleMatches(mod))
             {
                 IssueDebuggerBPCommand(bpLocation);
-                bpSet = TRUE;
-                break;
+                return TRUE;
             }
-
-            pCur = pNext;
         }
-
-        return bpSet;
+        return FALSE;
     }
 
     void RemovePendingForModule(TADDR mod)
     {
-        PendingBreakpoint *pCur = m_breakpoints;
+        if (m_count == 0)
+        {
+            return;
+        }
+
+        PendingBreakpoint *pCur = m_moduleBuckets[ModuleHash(mod) & (m_bucketCount - 1)];
         while(pCur)
         {
-            PendingBreakpoint *pNext = pCur->pNext;
+            PendingBreakpoint *pNext = pCur->pNextModule;
             if (pCur->ModuleMatches(mod))
             {
                 // Delete the current node, and keep going
@@ -5230,12 +5471,15 @@ public:
 
     void CleanupNotifications()
     {
-#ifdef FEATURE_PAL
         if (m_breakpoints == NULL)
         {
+            // Nothing refers to the interned strings anymore
+            m_names.Clear();
+            m_functionNames.Clear();
+#ifdef FEATURE_PAL
             g_ExtServices->ClearExceptionCallback();
-        }
 #endif
+        }
     }
 
     void ClearBreakpoint(size_t breakPointToClear)
@@ -5264,12 +5508,10 @@ public:
 
     void ClearAllBreakpoints()
     {
-        size_t iBreakpointIndex = 1;
         for (PendingBreakpoint *pCur = m_breakpoints; pCur != NULL; )
         {
             PendingBreakpoint* pNext = pCur->pNext;
             Delete(pCur);
-            iBreakpointIndex++;
             pCur = pNext;
         }
         CleanupNotifications();
@@ -5311,45 +5553,13 @@ public:
     HRESULT ResolvePendingNonModuleBoundBreakpoint(__in_z WCHAR* pModuleName, __in_z WCHAR* pMethodName, TADDR mod, DWORD ilOffset)
     {
         HRESULT Status = S_OK;
-        char szName[mdNameLen];
-        int numModule;
-
-        ToRelease<IXCLRDataModule> module;
-        IfFailRet(g_sos->GetModule(mod, &module));
-
-        WideCharToMultiByte(CP_ACP, 0, pModuleName, (int)(_wcslen(pModuleName) + 1), szName, mdNameLen, NULL, NULL);
-
-        ArrayHolder<DWORD_PTR> moduleList = ModuleFromName(szName, &numModule);
-        if (moduleList == NULL)
-        {
-            ExtOut("Failed to request module list.\n");
-            return E_FAIL;
-        }
-
-        for (int i = 0; i < numModule; i++)
+        BOOL bMatches = FALSE;
+        IfFailRet(ModuleNameMatches(pModuleName, mod, &bMatches));
+        if (!bMatches)
         {
-            // If any one entry in moduleList matches, then the current PendingBreakpoint
-            // is the right one.
-            if(moduleList[i] != TO_TADDR(mod))
-                continue;
-
-            CLRDATA_ENUM h;
-            if (module->StartEnumMethodDefinitionsByName(pMethodName, 0, &h) == S_OK)
-            {
-                IXCLRDataMethodDefinition *pMeth = NULL;
-                while (module->EnumMethodDefinitionByName(&h, &pMeth) == S_OK)
-                {
-                    mdMethodDef methodToken;
-                    ToRelease<IXCLRDataModule> pUnusedModule;
-                    IfFailRet(pMeth->GetTokenAndScope(&methodToken, &pUnusedModule));
-
-                    Add(pModuleName, pMethodName, methodToken, mod, ilOffset);
-                    pMeth->Release();
-                }
-                module->EndEnumMethodDefinitionsByName(h);
-            }
+            return S_OK;
         }
-        return S_OK;
+        return AddMethodDefinitions(pModuleName, pMethodName, mod, ilOffset);
     }
 
     // Return TRUE if there might be more instances that will be JITTED later
@@ -5414,42 +5624,81 @@ public:
     }
 
 private:
-    BOOL IsIn(__in_z LPWSTR szModule, __in_z LPWSTR szName, TADDR mod)
+    static ULONG ModuleHash(TADDR mod)
     {
-        PendingBreakpoint *pCur = m_breakpoints;
-        while(pCur)
+        return (ULONG)(((ULONG64)mod * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    static ULONG KeyHash(TADDR mod, ULONG64 key1, ULONG64 key2)
+    {
+        ULONG64 hash = ((ULONG64)mod ^ 0xCBF29CE484222325ull) * 0x9E3779B97F4A7C15ull;
+        hash = (hash ^ key1) * 0x9E3779B97F4A7C15ull;
+        hash = (hash ^ key2) * 0x9E3779B97F4A7C15ull;
+        return (ULONG)(hash >> 32);
+    }
+
+    static ULONG KeyHash(PendingBreakpoint *pBreakpoint)
+    {
+        if (pBreakpoint->methodToken != 0)
+            return KeyHash(pBreakpoint->pModule, pBreakpoint->methodToken, pBreakpoint->ilOffset);
+
+        if (pBreakpoint->szModuleName[0] != L'\0')
+            return KeyHash(pBreakpoint->pModule, (ULONG64)(size_t)pBreakpoint->szModuleName, (ULONG64)(size_t)pBreakpoint->szFunctionName);
+
+        return KeyHash(pBreakpoint->pModule, (ULONG64)(size_t)pBreakpoint->szFilename, pBreakpoint->lineNumber);
+    }
+
+    BOOL IsIn(__in_z LPCWSTR szModule, __in_z LPCWSTR szName, TADDR mod)
+    {
+        LPWSTR szModuleName = m_names.Find(szModule);
+        LPWSTR szFunctionName = m_functionNames.Find(szName);
+        if (m_count == 0 || szModuleName == NULL || szFunctionName == NULL)
+        {
+            return FALSE;
+        }
+        ULONG hash = KeyHash(mod, (ULONG64)(size_t)szModuleName, (ULONG64)(size_t)szFunctionName);
+        for (PendingBreakpoint *pCur = m_keyBuckets[hash & (m_bucketCount - 1)]; pCur != NULL; pCur = pCur->pNextKey)
         {
             if (pCur->ModuleMatches(mod) &&
-                _wcsicmp(pCur->szModuleName, szModule) == 0 &&
-                _wcscmp(pCur->szFunctionName, szName) == 0)
+                pCur->methodToken == 0 &&
+                pCur->szModuleName == szModuleName &&
+                pCur->szFunctionName == szFunctionName)
             {
                 return TRUE;
             }
-            pCur = pCur->pNext;
         }
         return FALSE;
     }
 
-    BOOL IsIn(__in_z LPWSTR szFilename, DWORD lineNumber, TADDR mod)
+    BOOL IsIn(__in_z LPCWSTR szFilename, DWORD lineNumber, TADDR mod)
     {
-        PendingBreakpoint *pCur = m_breakpoints;
-        while(pCur)
+        LPWSTR szFile = m_names.Find(szFilename);
+        if (m_count == 0 || szFile == NULL)
+        {
+            return FALSE;
+        }
+        ULONG hash = KeyHash(mod, (ULONG64)(size_t)szFile, lineNumber);
+        for (PendingBreakpoint *pCur = m_keyBuckets[hash & (m_bucketCount - 1)]; pCur != NULL; pCur = pCur->pNextKey)
         {
             if (pCur->ModuleMatches(mod) &&
-                _wcsicmp(pCur->szFilename, szFilename) == 0 &&
+                pCur->methodToken == 0 &&
+                pCur->szFilename == szFile &&
                 pCur->lineNumber == lineNumber)
             {
                 return TRUE;
             }
-            pCur = pCur->pNext;
         }
         return FALSE;
     }
 
     BOOL IsIn(mdMethodDef token, TADDR mod, DWORD ilOffset)
     {
-        PendingBreakpoint *pCur = m_breakpoints;
-        while(pCur)
+        if (m_count == 0)
+        {
+            return FALSE;
+        }
+        ULONG hash = KeyHash(mod, token, ilOffset);
+        for (PendingBreakpoint *pCur = m_keyBuckets[hash & (m_bucketCount - 1)]; pCur != NULL; pCur = pCur->pNextKey)
         {
             if (pCur->ModuleMatches(mod) &&
                 pCur->methodToken == token &&
@@ -5457,59 +5706,244 @@ private:
             {
                 return TRUE;
             }
-            pCur = pCur->pNext;
         }
         return FALSE;
     }
 
-    void Delete(PendingBreakpoint *pDelete)
+    // Allocates a breakpoint with interned copies of the names; NULL if out of memory
+    PendingBreakpoint* Create(__in_z_opt LPCWSTR szModule, __in_z_opt LPCWSTR szName, __in_z_opt LPCWSTR szFilename)
     {
-        PendingBreakpoint *pCur = m_breakpoints;
-        PendingBreakpoint *pPrev = NULL;
-        while(pCur)
+        PendingBreakpoint *pNew = new NOTHROW PendingBreakpoint();
+        if (pNew != NULL)
         {
-            if (pCur == pDelete)
+            pNew->szModuleName = m_names.Intern(szModule != NULL ? szModule : W(""));
+            pNew->szFunctionName = m_functionNames.Intern(szName != NULL ? szName : W(""));
+            pNew->szFilename = m_names.Intern(szFilename != NULL ? szFilename : W(""));
+            if (pNew->szModuleName != NULL && pNew->szFunctionName != NULL && pNew->szFilename != NULL)
             {
-                if (pPrev == NULL)
-                {
-                    m_breakpoints = pCur->pNext;
-                }
-                else
-                {
-                    pPrev->pNext = pCur->pNext;
-                }
-                delete pCur;
-                return;
+                return pNew;
             }
-            pPrev = pCur;
-            pCur = pCur->pNext;
+            delete pNew;
         }
+        ReportOOM();
+        return NULL;
+    }
+
+    BOOL Grow()
+    {
+        ULONG newBucketCount = m_bucketCount == 0 ? 64 : m_bucketCount * 2;
+        if (newBucketCount < m_bucketCount)
+            return FALSE;
+
+        PendingBreakpoint** newKeyBuckets = new NOTHROW PendingBreakpoint*[newBucketCount];
+        PendingBreakpoint** newModuleBuckets = new NOTHROW PendingBreakpoint*[newBucketCount];
+        if (newKeyBuckets == NULL || newModuleBuckets == NULL)
+        {
+            delete [] newKeyBuckets;
+            delete [] newModuleBuckets;
+            return FALSE;
+        }
+        memset(newKeyBuckets, 0, newBucketCount * sizeof(PendingBreakpoint*));
+        memset(newModuleBuckets, 0, newBucketCount * sizeof(PendingBreakpoint*));
+
+        delete [] m_keyBuckets;
+        delete [] m_moduleBuckets;
+        m_keyBuckets = newKeyBuckets;
+        m_moduleBuckets = newModuleBuckets;
+        m_bucketCount = newBucketCount;
+
+        for (PendingBreakpoint *pCur = m_breakpoints; pCur != NULL; pCur = pCur->pNext)
+        {
+            AddToIndexes(pCur);
+        }
+        return TRUE;
     }
 
+    void AddToIndexes(PendingBreakpoint *pBreakpoint)
+    {
+        PendingBreakpoint** ppKeyBucket = &m_keyBuckets[pBreakpoint->keyHash & (m_bucketCount - 1)];
+        pBreakpoint->pNextKey = *ppKeyBucket;
+        *ppKeyBucket = pBreakpoint;
 
+        PendingBreakpoint** ppModuleBucket = &m_moduleBuckets[ModuleHash(pBreakpoint->pModule) & (m_bucketCount - 1)];
+        pBreakpoint->pNextModule = *ppModuleBucket;
+        *ppModuleBucket = pBreakpoint;
+    }
 
-    HRESULT ResolvePendingNonModuleBoundBreakpoint(TADDR mod, PendingBreakpoint *pCur, SymbolReader* pSymbolReader)
+    void Insert(PendingBreakpoint *pNew)
     {
-        // This function only works with pending breakpoints that are not module bound.
-        if (pCur->pModule == (TADDR)0)
+        if (m_count >= m_bucketCount && !Grow())
+        {
+            delete pNew;
+            ReportOOM();
+            return;
+        }
+        pNew->keyHash = KeyHash(pNew);
+        pNew->pPrev = NULL;
+        pNew->pNext = m_breakpoints;
+        if (m_breakpoints != NULL)
         {
-            if (pCur->szModuleName[0] != L'\0')
+            m_breakpoints->pPrev = pNew;
+        }
+        m_breakpoints = pNew;
+        AddToIndexes(pNew);
+        m_count++;
+    }
+
+    void Delete(PendingBreakpoint *pDelete)
+    {
+        PendingBreakpoint** ppCur = &m_keyBuckets[pDelete->keyHash & (m_bucketCount - 1)];
+        while (*ppCur != pDelete)
+        {
+            ppCur = &(*ppCur)->pNextKey;
+        }
+        *ppCur = pDelete->pNextKey;
+
+        ppCur = &m_moduleBuckets[ModuleHash(pDelete->pModule) & (m_bucketCount - 1)];
+        while (*ppCur != pDelete)
+        {
+            ppCur = &(*ppCur)->pNextModule;
+        }
+        *ppCur = pDelete->pNextModule;
+
+        if (pDelete->pPrev == NULL)
+        {
+            m_breakpoints = pDelete->pNext;
+        }
+        else
+        {
+            pDelete->pPrev->pNext = pDelete->pNext;
+        }
+        if (pDelete->pNext != NULL)
+        {
+            pDelete->pNext->pPrev = pDelete->pPrev;
+        }
+        delete pDelete;
+        m_count--;
+    }
+
+    // Sets *pbMatches to TRUE if the module is one of the modules with the name
+    HRESULT ModuleNameMatches(__in_z WCHAR* pModuleName, TADDR mod, BOOL* pbMatches)
+    {
+        char szName[mdNameLen];
+        int numModule;
+
+        *pbMatches = FALSE;
+        WideCharToMultiByte(CP_ACP, 0, pModuleName, (int)(_wcslen(pModuleName) + 1), szName, mdNameLen, NULL, NULL);
+
+        ArrayHolder<DWORD_PTR> moduleList = ModuleFromName(szName, &numModule);
+        if (moduleList == NULL)
+        {
+            ExtOut("Failed to request module list.\n");
+            return E_FAIL;
+        }
+
+        for (int i = 0; i < numModule; i++)
+        {
+            if(moduleList[i] == TO_TADDR(mod))
             {
-                return ResolvePendingNonModuleBoundBreakpoint(pCur->szModuleName, pCur->szFunctionName, mod, pCur->ilOffset);
+                *pbMatches = TRUE;
+                break;
             }
-            else
+        }
+        return S_OK;
+    }
+
+    // Adds a module bound breakpoint for each method definition with the name
+    HRESULT AddMethodDefinitions(__in_z WCHAR* pModuleName, __in_z WCHAR* pMethodName, TADDR mod, DWORD ilOffset)
+    {
+        HRESULT Status = S_OK;
+        ToRelease<IXCLRDataModule> module;
+        IfFailRet(g_sos->GetModule(mod, &module));
+
+        CLRDATA_ENUM h;
+        if (module->StartEnumMethodDefinitionsByName(pMethodName, 0, &h) == S_OK)
+        {
+            IXCLRDataMethodDefinition *pMeth = NULL;
+            while (module->EnumMethodDefinitionByName(&h, &pMeth) == S_OK)
             {
-                return ResolvePendingNonModuleBoundBreakpoint(pCur->szFilename, pCur->lineNumber, mod, pSymbolReader);
+                mdMethodDef methodToken;
+                ToRelease<IXCLRDataModule> pUnusedModule;
+                IfFailRet(pMeth->GetTokenAndScope(&methodToken, &pUnusedModule));
+
+                Add(pModuleName, pMethodName, methodToken, mod, ilOffset);
+                pMeth->Release();
             }
+            module->EndEnumMethodDefinitionsByName(h);
         }
-        else
+        return S_OK;
+    }
+
+    // Binds the breakpoints that aren't bound to a module yet to the new module
+    void ResolvePendingNonModuleBoundBreakpoints(TADDR mod, SymbolReader* pSymbolReader)
+    {
+        if (m_count == 0)
         {
-            return S_OK;
+            return;
+        }
+
+        // Binding adds new breakpoints (which can grow the indexes) so work
+        // from a snapshot of the unbound ones.
+        PendingBreakpoint** ppBucket = &m_moduleBuckets[ModuleHash(0) & (m_bucketCount - 1)];
+        ULONG count = 0;
+        for (PendingBreakpoint *pCur = *ppBucket; pCur != NULL; pCur = pCur->pNextModule)
+        {
+            if (pCur->ModuleMatches(0))
+                count++;
+        }
+        if (count == 0)
+        {
+            return;
+        }
+        ArrayHolder<PendingBreakpoint*> unbound = new NOTHROW PendingBreakpoint*[count];
+        ArrayHolder<LPWSTR> matchedNames = new NOTHROW LPWSTR[count];
+        ArrayHolder<BOOL> matches = new NOTHROW BOOL[count];
+        if (unbound == NULL || matchedNames == NULL || matches == NULL)
+        {
+            ReportOOM();
+            return;
+        }
+        ULONG index = 0;
+        for (PendingBreakpoint *pCur = *ppBucket; pCur != NULL; pCur = pCur->pNextModule)
+        {
+            if (pCur->ModuleMatches(0))
+                unbound[index++] = pCur;
+        }
+
+        // The module names are interned so each distinct name only has to be
+        // matched against the module once.
+        ULONG matchedCount = 0;
+        for (ULONG i = 0; i < count; i++)
+        {
+            PendingBreakpoint *pCur = unbound[i];
+            if (pCur->szModuleName[0] == L'\0')
+            {
+                ResolvePendingNonModuleBoundBreakpoint(pCur->szFilename, pCur->lineNumber, mod, pSymbolReader);
+                continue;
+            }
+            ULONG j = 0;
+            while (j < matchedCount && matchedNames[j] != pCur->szModuleName)
+            {
+                j++;
+            }
+            if (j == matchedCount)
+            {
+                matchedNames[j] = pCur->szModuleName;
+                if (FAILED(ModuleNameMatches(pCur->szModuleName, mod, &matches[j])))
+                {
+                    matches[j] = FALSE;
+                }
+                matchedCount++;
+            }
+            if (matches[j])
+            {
+                AddMethodDefinitions(pCur->szModuleName, pCur->szFunctionName, mod, pCur->ilOffset);
+            }
         }
     }
 
     // Returns TRUE if further instances may be jitted, FALSE if all instances are now resolved
-    BOOL ResolvePendingBreakpoint(TADDR addr, PendingBreakpoint *pCur)
+    BOOL ResolvePendingBreakpoint(TADDR addr, IXCLRDataModule *mod, PendingBreakpoint *pCur)
     {
         // Only go forward if the module matches the current PendingBreakpoint
         if (!pCur->ModuleMatches(addr))
@@ -5517,12 +5951,6 @@ private:
             return FALSE;
         }
 
-        ToRelease<IXCLRDataModule> mod;
-        if (FAILED(g_sos->GetModule(addr, &mod)))
-        {
-            return FALSE;
-        }
-
         if(pCur->methodToken == 0)
         {
             return FALSE;
@@ -8058,21 +8486,58 @@ DECLARE_API(EEVersion)
 *    This function the global SOS status                               *
 *                                                                      *
 \**********************************************************************/
+static void DisplayMemoryReadStatistics()
+{
+    IDebuggerServices* debuggerServices = GetDebuggerServices();
+    if (debuggerServices != nullptr)
+    {
+        MEMORY_READ_STATISTICS statistics;
+        if (SUCCEEDED(debuggerServices->GetMemoryReadStatistics(&statistics)))
+        {
+            ExtOut("Unreadable memory ranges cached: %u (%I64u reads failed fast)\n", statistics.unreadableRanges, statistics.unreadableHits);
+        }
+    }
+}
+
 DECLARE_API(SOSStatus)
 {
-    INIT_API_NOEE_PROBE_MANAGED("sosstatus");
+    INIT_API_EXT();
 
     BOOL bReset = FALSE;
+    BOOL bPerf = FALSE;
     CMDOption option[] =
     {   // name, vptr, type, hasValue
         {"-reset", &bReset, COBOOL, FALSE},
         {"--reset", &bReset, COBOOL, FALSE},
         {"-r", &bReset, COBOOL, FALSE},
+        {"-perf", &bPerf, COBOOL, FALSE},
+        {"--perf", &bPerf, COBOOL, FALSE},
     };
     if (!GetCMDOption(args, option, ARRAY_SIZE(option), NULL, 0, NULL))
     {
         return E_INVALIDARG;
     }
+
+    // The read counters are kept by the native SOS code whether hosted or not
+    if (bPerf)
+    {
+        DisplayPerfCounters();
+        return S_OK;
+    }
+
+    // The managed status is displayed if hosted followed by the native debugger's counters
+    if ((Status = ExecuteCommand("sosstatus", args)) != E_NOTIMPL)
+    {
+        if (!bReset)
+        {
+            DisplayMemoryReadStatistics();
+        }
+        return Status;
+    }
+    if ((Status = ArchQuery()) != S_OK)
+    {
+        return Status;
+    }
     if (bReset)
     {
         ITarget* target = GetTarget();
@@ -8080,10 +8545,12 @@ DECLARE_API(SOSStatus)
         {
             target->Flush();
         }
+        FlushSOSCaches();
         ExtOut("Internal cached state reset\n");
         return S_OK;
     }
     Target::DisplayStatus();
+    DisplayMemoryReadStatistics();
     ExtOut("Using no runtime to host the managed SOS code. Some commands are not availible.\n");
     return S_OK;
 }
@@ -8688,6 +9155,10 @@ public:
     }
 
 private:
+    // The number of handles prefetched together. It matches the read cache's largest
+    // prefetch batch so a window's objects are read with one debugger call.
+    static const unsigned int HandleWindowSize = 64;
+
     void WalkHandles()
     {
         ToRelease<ISOSHandleEnum> handles;
@@ -8706,6 +9177,11 @@ private:
         SOSHandleData data[4];
 #endif
 
+        // The handles that pass the -type filter are gathered across the enumeration chunks
+        // so their slots and objects are prefetched a full window at a time.
+        std::vector<SOSHandleData> window;
+        window.reserve(HandleWindowSize);
+
         unsigned int fetched = 0;
         HRESULT hr = S_OK;
         do
@@ -8716,12 +9192,53 @@ private:
                 break;
             }
 
-            WalkHandles(data, fetched);
+            for (unsigned int i = 0; i < fetched; ++i)
+            {
+                if (mType != (unsigned int)~0 && mType != data[i].Type)
+                    continue;
+
+                window.push_back(data[i]);
+                if (window.size() == HandleWindowSize)
+                {
+                    WalkHandles(window.data(), (unsigned int)window.size());
+                    window.clear();
+                }
+            }
         } while (ARRAY_SIZE(data) == fetched);
+
+        if (!window.empty())
+        {
+            WalkHandles(window.data(), (unsigned int)window.size());
+        }
+    }
+
+    // Loads the handle slots and then the objects they point to into the read cache in
+    // two batches instead of several debugger round trips per handle.
+    void PrefetchHandles(SOSHandleData data[], unsigned int count)
+    {
+        TADDR addresses[HandleWindowSize];
+        _ASSERTE(count <= HandleWindowSize);
+
+        for (unsigned int i = 0; i < count; ++i)
+            addresses[i] = TO_TADDR(data[i].Handle);
+
+        rvCache->Prefetch(addresses, count, sizeof(TADDR));
+
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            TADDR objAddr = 0;
+            if (FAILED(MOVE(objAddr, addresses[i])))
+                objAddr = 0;
+            addresses[i] = objAddr;
+        }
+
+        rvCache->Prefetch(addresses, count, sizeof(TADDR) + sizeof(DWORD));
     }
 
     void WalkHandles(SOSHandleData data[], unsigned int count)
     {
+        PrefetchHandles(data, count);
+
         for (unsigned int i = 0; i < count; ++i)
         {
             sos::CheckInterrupt();
@@ -10384,7 +10901,7 @@ void PrintRef(const SOSStackRefData &ref, TableOutput &out)
 class ClrStackImpl
 {
 public:
-    static void PrintThread(ULONG osID, BOOL bParams, BOOL bLocals, BOOL bSuppressLines, BOOL bGC, BOOL bFull, BOOL bDisplayRegVals, size_t nFrames)
+    static void PrintThread(ULONG osID, BOOL bParams, BOOL bLocals, BOOL bSuppressLines, BOOL bGC, BOOL bFull, BOOL bDisplayRegVals, size_t nFrames, IXCLRDataTask *pTask = NULL)
     {
         _ASSERTE(g_targetMachine != nullptr);
 
@@ -10400,7 +10917,7 @@ public:
 
         ToRelease<IXCLRDataStackWalk> pStackWalk;
 
-        HRESULT hr = CreateStackWalk(osID, &pStackWalk);
+        HRESULT hr = CreateStackWalk(osID, pTask, &pStackWalk);
         if (FAILED(hr) || pStackWalk == NULL)
         {
             ExtOut("Failed to start stack walk: %lx\n", hr);
@@ -10769,6 +11286,12 @@ public:
             return;
         }
 
+        // Looking up each thread's task with GetTaskByOSThreadID searches the runtime's thread
+        // list every time, which makes -all quadratic in the number of threads. Enumerate the
+        // tasks once up front instead; threads missing from the map fall back to the lookup.
+        TaskMap tasks;
+        GetAllTasks(tasks);
+
         DacpThreadData Thread;
         CLRDATA_ADDRESS CurThread = ThreadStore.firstThread;
         while (CurThread != 0)
@@ -10784,19 +11307,51 @@ public:
             if (Thread.osThreadId != 0)
             {
                 ExtOut("OS Thread Id: 0x%x\n", Thread.osThreadId);
-                PrintThread(Thread.osThreadId, bParams, bLocals, bSuppressLines, bGC, bNative, bDisplayRegVals, nFrames);
+                TaskMap::iterator task = tasks.find(Thread.osThreadId);
+                PrintThread(Thread.osThreadId, bParams, bLocals, bSuppressLines, bGC, bNative, bDisplayRegVals, nFrames,
+                    task != tasks.end() ? task->second.GetPtr() : NULL);
             }
             CurThread = Thread.nextThread;
         }
     }
 
 private:
-    static HRESULT CreateStackWalk(ULONG osID, IXCLRDataStackWalk **ppStackwalk)
+    typedef std::map<ULONG, ToRelease<IXCLRDataTask>> TaskMap;
+
+    static void GetAllTasks(TaskMap &tasks)
+    {
+        CLRDATA_ENUM handle;
+        if (g_clrData->StartEnumTasks(&handle) != S_OK)
+            return;
+
+        IXCLRDataTask *pTask = NULL;
+        while (!IsInterrupt() && g_clrData->EnumTask(&handle, &pTask) == S_OK)
+        {
+            ULONG32 osID = 0;
+            if (SUCCEEDED(pTask->GetOSThreadID(&osID)) && osID != 0 && tasks.find(osID) == tasks.end())
+            {
+                tasks[osID] = pTask;
+            }
+            else
+            {
+                pTask->Release();
+            }
+            pTask = NULL;
+        }
+        g_clrData->EndEnumTasks(handle);
+    }
+
+    static HRESULT CreateStackWalk(ULONG osID, IXCLRDataTask *pKnownTask, IXCLRDataStackWalk **ppStackwalk)
     {
         HRESULT hr = S_OK;
         ToRelease<IXCLRDataTask> pTask;
 
-        if ((hr = g_clrData->GetTaskByOSThreadID(osID, &pTask)) != S_OK)
+        if (pKnownTask != NULL)
+        {
+            pKnownTask->AddRef();
+            pTask = pKnownTask;
+        }
+        else if ((hr = g_clrData->GetTaskByOSThreadID(osID, &pTask)) != S_OK)
         {
             ExtOut("Unable to walk the managed stack. The current thread is likely not a \n");
             ExtOut("managed thread. You can run %sclrthreads to get a list of managed threads in\n", SOSPrefix);
@@ -11325,6 +11880,7 @@ DECLARE_API(SOSFlush)
     {
         target->Flush();
     }
+    FlushSOSCaches();
     ExtOut("Internal cached state reset\n");
     return S_OK;
 }
@@ -11995,7 +12551,7 @@ HRESULT CALLBACK ImplementEFNStackTrace(
         PDEBUG_STACK_FRAME pCur = g_Frames + i;
 
         CLRDATA_ADDRESS pMD;
-        if (g_sos->GetMethodDescPtrFromIP(pCur->InstructionOffset, &pMD) == S_OK)
+        if (RequestMethodDescPtrFromIP(pCur->InstructionOffset, &pMD) == S_OK)
         {
             if (bInNative || transitionContextCount==0)
             {
@@ -12101,7 +12657,7 @@ Exit:
             }
 
             // we may have a method, try to get the methoddesc
-            if (g_sos->GetMethodDescPtrFromIP(GetIP(context), &pMD)==S_OK)
+            if (RequestMethodDescPtrFromIP(GetIP(context), &pMD)==S_OK)
             {
                 Status = DumpMDInfoBuffer((DWORD_PTR) pMD, Flags,
                                           GetSP(context), GetIP(context), so);
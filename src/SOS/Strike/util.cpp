@@ -37,8 +37,12 @@
 #endif // !FEATURE_PAL
 
 #include <coreclrhost.h>
+#include <algorithm>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #if defined(__APPLE__)
 #include <mach-o/dyld.h>
@@ -311,13 +315,21 @@ BOOL IsRetailBuild (size_t base)
 \**********************************************************************/
 BOOL SafeReadMemory (TADDR offset, PVOID lpBuffer, ULONG cb, PULONG lpcbBytesRead)
 {
-    BOOL bRet = SUCCEEDED(g_ExtData->ReadVirtual(TO_CDADDR(offset), lpBuffer, cb, lpcbBytesRead));
-    if (!bRet)
+    ULONG cbBytesRead = 0;
+    HRESULT hr = g_ExtData->ReadVirtual(TO_CDADDR(offset), lpBuffer, cb, &cbBytesRead);
+    PerfCountRead(hr, cbBytesRead);
+    if (FAILED(hr))
     {
         cb = _min(cb, (ULONG)(NextOSPageAddress(offset) - offset));
-        bRet = SUCCEEDED(g_ExtData->ReadVirtual(TO_CDADDR(offset), lpBuffer, cb, lpcbBytesRead));
+        cbBytesRead = 0;
+        hr = g_ExtData->ReadVirtual(TO_CDADDR(offset), lpBuffer, cb, &cbBytesRead);
+        PerfCountRead(hr, cbBytesRead);
+    }
+    if (lpcbBytesRead != NULL)
+    {
+        *lpcbBytesRead = cbBytesRead;
     }
-    return bRet;
+    return SUCCEEDED(hr);
 }
 
 ULONG OSPageSize ()
@@ -336,6 +348,197 @@ size_t NextOSPageAddress (size_t addr)
 }
 
 
+//---------------------------------------------------------------------------------------
+//
+// Native code ranges of the methods the stack commands resolved during the current cache
+// epoch (see FlushSOSCaches). EEStack, ClrStack and DumpStack resolve the same methods
+// for every thread; after the first DAC request for a method the rest of the IPs in its
+// code are answered with a binary search.
+//
+class CodeRangeCache
+{
+    struct Range
+    {
+        CLRDATA_ADDRESS start;
+        CLRDATA_ADDRESS end;        // Exclusive
+        size_t header;              // Index in m_headers
+    };
+
+    struct LookupResult
+    {
+        HRESULT hr;
+        CLRDATA_ADDRESS value;
+    };
+
+    std::vector<Range> m_ranges;                                    // Sorted, not overlapping
+    std::vector<DacpCodeHeaderData> m_headers;
+    std::unordered_map<CLRDATA_ADDRESS, HRESULT> m_codeHeaderFailures;
+    std::unordered_map<CLRDATA_ADDRESS, LookupResult> m_methodDescs;  // IPs outside the code ranges (stubs)
+    std::unordered_map<CLRDATA_ADDRESS, std::basic_string<WCHAR>> m_names;
+
+    const DacpCodeHeaderData* Find(CLRDATA_ADDRESS ip)
+    {
+        auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), ip,
+            [](CLRDATA_ADDRESS value, const Range& range) { return value < range.start; });
+        if (it == m_ranges.begin())
+        {
+            return NULL;
+        }
+        --it;
+        return ip < it->end ? &m_headers[it->header] : NULL;
+    }
+
+    bool AddRange(CLRDATA_ADDRESS start, CLRDATA_ADDRESS end, size_t header)
+    {
+        if (start >= end)
+        {
+            return false;
+        }
+        auto it = std::upper_bound(m_ranges.begin(), m_ranges.end(), start,
+            [](CLRDATA_ADDRESS value, const Range& range) { return value < range.start; });
+        if ((it != m_ranges.end() && it->start < end) || (it != m_ranges.begin() && (it - 1)->end > start))
+        {
+            return false;
+        }
+        Range range = { start, end, header };
+        m_ranges.insert(it, range);
+        return true;
+    }
+
+    // Adds the hot and cold code of the method. Returns false if the IP isn't in either
+    // one, for example when the header describes a stub.
+    bool AddCodeHeader(CLRDATA_ADDRESS ip, const DacpCodeHeaderData& codeHeaderData)
+    {
+        CLRDATA_ADDRESS hotStart = codeHeaderData.MethodStart;
+        CLRDATA_ADDRESS hotEnd = hotStart + (codeHeaderData.ColdRegionSize != 0 && codeHeaderData.HotRegionSize != 0 ?
+            codeHeaderData.HotRegionSize : codeHeaderData.MethodSize);
+        CLRDATA_ADDRESS coldStart = codeHeaderData.ColdRegionStart;
+        CLRDATA_ADDRESS coldEnd = coldStart + codeHeaderData.ColdRegionSize;
+
+        bool inHot = hotStart != 0 && ip >= hotStart && ip < hotEnd;
+        bool inCold = coldStart != 0 && ip >= coldStart && ip < coldEnd;
+        if (!inHot && !inCold)
+        {
+            return false;
+        }
+        size_t header = m_headers.size();
+        m_headers.push_back(codeHeaderData);
+        bool added = AddRange(hotStart, hotEnd, header);
+        if (coldStart != 0)
+        {
+            added = AddRange(coldStart, coldEnd, header) || added;
+        }
+        return added;
+    }
+
+public:
+    HRESULT GetCodeHeaderData(CLRDATA_ADDRESS ip, DacpCodeHeaderData* pCodeHeaderData)
+    {
+        const DacpCodeHeaderData* cached = Find(ip);
+        if (cached != NULL)
+        {
+            *pCodeHeaderData = *cached;
+            return S_OK;
+        }
+        auto failure = m_codeHeaderFailures.find(ip);
+        if (failure != m_codeHeaderFailures.end())
+        {
+            return failure->second;
+        }
+        HRESULT hr = pCodeHeaderData->Request(g_sos, ip);
+        if (hr == S_OK)
+        {
+            AddCodeHeader(ip, *pCodeHeaderData);
+        }
+        else
+        {
+            m_codeHeaderFailures[ip] = hr;
+        }
+        return hr;
+    }
+
+    HRESULT GetMethodDescPtrFromIP(CLRDATA_ADDRESS ip, CLRDATA_ADDRESS* pMD)
+    {
+        const DacpCodeHeaderData* cached = Find(ip);
+        if (cached != NULL && cached->MethodDescPtr != 0)
+        {
+            *pMD = cached->MethodDescPtr;
+            return S_OK;
+        }
+        auto found = m_methodDescs.find(ip);
+        if (found != m_methodDescs.end())
+        {
+            *pMD = found->second.value;
+            return found->second.hr;
+        }
+
+        // Resolving the code header first lets the later IPs in the same method hit the cache
+        DacpCodeHeaderData codeHeaderData;
+        if (cached == NULL && m_codeHeaderFailures.find(ip) == m_codeHeaderFailures.end())
+        {
+            HRESULT hr = codeHeaderData.Request(g_sos, ip);
+            if (hr != S_OK)
+            {
+                m_codeHeaderFailures[ip] = hr;
+            }
+            else if (AddCodeHeader(ip, codeHeaderData) && codeHeaderData.MethodDescPtr != 0)
+            {
+                *pMD = codeHeaderData.MethodDescPtr;
+                return S_OK;
+            }
+        }
+
+        LookupResult result;
+        result.value = 0;
+        result.hr = g_sos->GetMethodDescPtrFromIP(ip, &result.value);
+        m_methodDescs[ip] = result;
+        *pMD = result.value;
+        return result.hr;
+    }
+
+    HRESULT GetMethodDescName(CLRDATA_ADDRESS md, ULONG32 count, __out_ecount(count) WCHAR* name)
+    {
+        auto found = m_names.find(md);
+        if (found != m_names.end() && found->second.length() < count)
+        {
+            wcscpy_s(name, count, found->second.c_str());
+            return S_OK;
+        }
+        HRESULT hr = g_sos->GetMethodDescName(md, count, name, NULL);
+        if (hr == S_OK)
+        {
+            m_names[md] = name;
+        }
+        return hr;
+    }
+
+    void Clear()
+    {
+        m_ranges.clear();
+        m_headers.clear();
+        m_codeHeaderFailures.clear();
+        m_methodDescs.clear();
+        m_names.clear();
+    }
+};
+
+static CodeRangeCache s_codeRangeCache;
+
+HRESULT RequestCodeHeaderData(CLRDATA_ADDRESS ip, DacpCodeHeaderData* pCodeHeaderData)
+{
+    return s_codeRangeCache.GetCodeHeaderData(ip, pCodeHeaderData);
+}
+
+HRESULT RequestMethodDescPtrFromIP(CLRDATA_ADDRESS ip, CLRDATA_ADDRESS* pMD)
+{
+    return s_codeRangeCache.GetMethodDescPtrFromIP(ip, pMD);
+}
+
+HRESULT RequestMethodDescName(CLRDATA_ADDRESS md, ULONG32 count, __out_ecount(count) WCHAR* name)
+{
+    return s_codeRangeCache.GetMethodDescName(md, count, name);
+}
+
 /**********************************************************************\
 * Routine Description:                                                 *
 *                                                                      *
@@ -353,7 +556,7 @@ void IP2MethodDesc (DWORD_PTR IP, DWORD_PTR &methodDesc, JITTypes &jitType,
     methodDesc = (TADDR)0;
     gcinfoAddr = (TADDR)0;
 
-    if (codeHeaderData.Request(g_sos, EIP) != S_OK)
+    if (RequestCodeHeaderData(EIP, &codeHeaderData) != S_OK)
     {
         return;
     }
@@ -1043,6 +1246,14 @@ void DisplayFields(CLRDATA_ADDRESS cdaMT, DacpMethodTableData *pMTD, DacpMethodT
 
     BOOL fIsShared = pMTD->bIsShared;
 
+    // Load the instance field data up front in one batch; every DisplayDataMember
+    // below is then served from the read cache.
+    if (bFirst && dwStartAddr > 0 && pMTD->BaseSize > 0)
+    {
+        TADDR address = TO_TADDR(dwStartAddr);
+        rvCache->Prefetch(&address, 1, _min(pMTD->BaseSize, (DWORD)CACHE_SIZE));
+    }
+
     if (pMTD->ParentMethodTable)
     {
         DacpMethodTableData vParentMethTable;
@@ -1792,7 +2003,7 @@ BOOL NameForMD_s (DWORD_PTR pMD, __out_ecount (capacity_mdName) WCHAR *mdName, s
         return FALSE;
     }
 
-    if (g_sos->GetMethodDescName(StartAddr, mdNameLen, mdName, NULL) != S_OK)
+    if (RequestMethodDescName(StartAddr, mdNameLen, mdName) != S_OK)
     {
         wcscpy_s(mdName, capacity_mdName, W("UNKNOWN"));
         return FALSE;
@@ -2044,45 +2255,6 @@ BOOL TryGetMethodDescriptorForDelegate(CLRDATA_ADDRESS delegateAddr, CLRDATA_ADD
     return FALSE;
 }
 
-void AddToModuleList(DWORD_PTR * &moduleList, int &numModule, int &maxList,
-                     DWORD_PTR dwModuleAddr)
-{
-    int i;
-    for (i = 0; i < numModule; i ++)
-    {
-        if (moduleList[i] == dwModuleAddr)
-            break;
-    }
-    if (i == numModule)
-    {
-        moduleList[numModule] = dwModuleAddr;
-        numModule ++;
-        if (numModule == maxList)
-        {
-            int listLength = 0;
-            if (!ClrSafeInt<int>::multiply(maxList, 2, listLength))
-            {
-                ExtOut("<integer overflow>\n");
-                numModule = 0;
-                ControlC = 1;
-                return;
-            }
-            DWORD_PTR *list = new DWORD_PTR [listLength];
-
-            if (list == NULL)
-            {
-                numModule = 0;
-                ControlC = 1;
-                return;
-            }
-            memcpy (list, moduleList, maxList * sizeof(PVOID));
-            delete[] moduleList;
-            moduleList = list;
-            maxList *= 2;
-        }
-    }
-}
-
 BOOL IsFusionLoadedModule (LPCSTR fusionName, LPCSTR mName)
 {
     // The fusion name will be in this format:
@@ -2116,14 +2288,11 @@ BOOL IsFusionLoadedModule (LPCSTR fusionName, LPCSTR mName)
     return FALSE;
 }
 
-BOOL DebuggerModuleNamesMatch (CLRDATA_ADDRESS PEFileAddr, ___in __in_z LPSTR mName)
+// Another way to see if a module is the same is to accept that the name
+// may be the debugger's name for a loaded module. This returns the
+// debugger's name for the module's PE file.
+static BOOL GetDebuggerModuleName (CLRDATA_ADDRESS PEFileAddr, __out_ecount(nameSize) LPSTR name, ULONG nameSize)
 {
-    // Another way to see if a module is the same is
-    // to accept that mName may be the debugger's name for
-    // a loaded module. We can get the debugger's name for
-    // the module we are looking at right now, and compare
-    // it with mName, if they match exactly, we can add
-    // the module to the list.
     if (PEFileAddr)
     {
         CLRDATA_ADDRESS pebase = 0;
@@ -2135,15 +2304,10 @@ BOOL DebuggerModuleNamesMatch (CLRDATA_ADDRESS PEFileAddr, ___in __in_z LPSTR mN
                 ULONG64 base;
                 if (g_ExtSymbols->GetModuleByOffset(pebase, 0, &Index, &base) == S_OK)
                 {
-                    CHAR ModuleName[MAX_LONGPATH+1];
-
-                    if (g_ExtSymbols->GetModuleNames(Index, base, NULL, 0, NULL, ModuleName,
-                        MAX_LONGPATH, NULL, NULL, 0, NULL) == S_OK)
+                    if (g_ExtSymbols->GetModuleNames(Index, base, NULL, 0, NULL, name,
+                        nameSize, NULL, NULL, 0, NULL) == S_OK)
                     {
-                        if (_stricmp (ModuleName, mName) == 0)
-                        {
-                            return TRUE;
-                        }
+                        return TRUE;
                     }
                 }
             }
@@ -2152,20 +2316,94 @@ BOOL DebuggerModuleNamesMatch (CLRDATA_ADDRESS PEFileAddr, ___in __in_z LPSTR mN
     return FALSE;
 }
 
-DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
+//---------------------------------------------------------------------------------------
+//
+// The loaded modules and their names, indexed once per cache epoch (see FlushSOSCaches)
+// instead of walking every AppDomain, assembly and module on each ModuleFromName call.
+// The names are only collected on the first lookup by name.
+//
+class ModuleNameIndex
 {
-    if (numModule == NULL)
-        return NULL;
+    typedef std::unordered_map<std::string, std::vector<int>> NameMap;
 
-    DWORD_PTR *moduleList = NULL;
-    *numModule = 0;
+    bool m_populated;
+    bool m_namesPopulated;
+    std::vector<DWORD_PTR> m_modules;           // In enumeration order, without duplicates
+    std::vector<std::string> m_fileNames;       // Indexed like m_modules
+    NameMap m_byFileName;                       // By the file name without the path
+    NameMap m_byDebuggerName;                   // By the lower cased debugger module name
+    std::vector<int> m_fusionNames;             // The modules named by an assembly display name
+
+    // The part of the name IsSameModuleName always compares, normalized the same way
+    static std::string FileNameKey(LPCSTR name)
+    {
+        LPCSTR start = name;
+        for (LPCSTR ptr = name; *ptr != '\0'; ptr++)
+        {
+            if (*ptr == GetTargetDirectorySeparatorW() || *ptr == ':')
+            {
+                start = ptr + 1;
+            }
+        }
+        std::string key(start);
+#ifndef FEATURE_PAL
+        for (char& ch : key)
+        {
+            ch = (char)tolower(ch);
+        }
+#endif
+        return key;
+    }
+
+    static std::string DebuggerNameKey(LPCSTR name)
+    {
+        std::string key(name);
+        for (char& ch : key)
+        {
+            ch = (char)tolower(ch);
+        }
+        return key;
+    }
 
+    static void AddMatches(const NameMap& map, const std::string& key, std::vector<int>& matches)
+    {
+        auto found = map.find(key);
+        if (found != map.end())
+        {
+            matches.insert(matches.end(), found->second.begin(), found->second.end());
+        }
+    }
+
+    HRESULT Populate();
+    HRESULT PopulateNames();
+
+public:
+    ModuleNameIndex() : m_populated(false), m_namesPopulated(false)
+    {
+    }
+
+    void Clear()
+    {
+        m_populated = false;
+        m_namesPopulated = false;
+        m_modules.clear();
+        m_fileNames.clear();
+        m_byFileName.clear();
+        m_byDebuggerName.clear();
+        m_fusionNames.clear();
+    }
+
+    DWORD_PTR *Find(__in_opt LPCSTR mName, int *numModule);
+};
+
+HRESULT ModuleNameIndex::Populate()
+{
     HRESULT hr;
     DacpAppDomainStoreData adsData;
     if ((hr = adsData.Request(g_sos)) != S_OK)
     {
         ExtDbgOut("DacpAppDomainStoreData.Request FAILED %08x\n", hr);
-        return NULL;
+        return hr;
     }
 
     ArrayHolder<CLRDATA_ADDRESS> pAssemblyArray = NULL;
@@ -2176,16 +2414,16 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
         numSpecialDomains++;
     if (adsData.sharedDomain != (TADDR)0)
         numSpecialDomains++;
-    if (!ClrSafeInt<int>::addition(adsData.DomainCount, numSpecialDomains, arrayLength))
+    if (!ClrSafeInt<int>::addition(adsData.DomainCount, numSpecialDomains, arrayLength) || arrayLength <= 0)
     {
         ExtOut("<integer overflow>\n");
-        return NULL;
+        return E_FAIL;
     }
     ArrayHolder<CLRDATA_ADDRESS> pArray = new CLRDATA_ADDRESS[arrayLength];
     if (pArray == NULL)
     {
         ReportOOM();
-        return NULL;
+        return E_OUTOFMEMORY;
     }
 
     int i = 0;
@@ -2200,34 +2438,18 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
     if ((hr = g_sos->GetAppDomainList(adsData.DomainCount, pArray.GetPtr() + numSpecialDomains, NULL)) != S_OK)
     {
         ExtOut("Unable to get array of AppDomains: %08x\n", hr);
-        return NULL;
-    }
-
-    // List all domain
-    size_t AllocSize;
-    int maxList = arrayLength; // account for system and shared domains
-    if (maxList <= 0 || !ClrSafeInt<size_t>::multiply(maxList, sizeof(PVOID), AllocSize))
-    {
-        ExtOut("<integer overflow>\n");
-        return NULL;
-    }
-
-    moduleList = new DWORD_PTR[maxList];
-    if (moduleList == NULL)
-    {
-        ReportOOM();
-        return NULL;
+        return hr;
     }
 
-    ArrayHolder<char> fileName = new char[MAX_LONGPATH];
+    std::unordered_set<DWORD_PTR> seen;
 
-    // Search all domains to find a module
+    // Search all domains to find the modules
     for (int n = 0; n < adsData.DomainCount+numSpecialDomains; n++)
     {
         if (IsInterrupt())
         {
             ExtOut("<interrupted>\n");
-            goto Failure;
+            return E_ABORT;
         }
 
         DacpAppDomainData appDomain;
@@ -2244,7 +2466,7 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
 
             // we will correctly give the answer that whatever module you were looking for, it isn't loaded yet
             ExtDbgOut("DacpAppDomainData.Request FAILED %08x\n", hr);
-            goto Failure;
+            return hr;
         }
 
         if (appDomain.AssemblyCount)
@@ -2253,13 +2475,13 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
             if (pAssemblyArray==NULL)
             {
                 ReportOOM();
-                goto Failure;
+                return E_OUTOFMEMORY;
             }
 
             if (FAILED(hr = g_sos->GetAssemblyList(appDomain.AppDomainPtr, appDomain.AssemblyCount, pAssemblyArray, NULL)))
             {
                 ExtOut("Unable to get array of Assemblies for the given AppDomain: %08x\n", hr);
-                goto Failure;
+                return hr;
             }
 
             for (int nAssem = 0; nAssem < appDomain.AssemblyCount; nAssem ++)
@@ -2267,7 +2489,7 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
                 if (IsInterrupt())
                 {
                     ExtOut("<interrupted>\n");
-                    goto Failure;
+                    return E_ABORT;
                 }
 
                 DacpAssemblyData assemblyData;
@@ -2279,7 +2501,7 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
                     // test failures on Alpine x64 8.0 legs.
                     if (IsRuntimeVersionAtLeast(9))
                     {
-                        goto Failure;
+                        return hr;
                     }
                     continue;
                 }
@@ -2288,7 +2510,7 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
                 if (FAILED(hr = g_sos->GetAssemblyModuleList(assemblyData.AssemblyPtr, assemblyData.ModuleCount, pModules, NULL)))
                 {
                     ExtOut("Failed to get the modules for the given assembly: %08x\n", hr);
-                    goto Failure;
+                    return hr;
                 }
 
                 for (UINT nModule = 0; nModule < assemblyData.ModuleCount; nModule++)
@@ -2296,7 +2518,7 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
                     if (IsInterrupt())
                     {
                         ExtOut("<interrupted>\n");
-                        goto Failure;
+                        return E_ABORT;
                     }
 
                     CLRDATA_ADDRESS ModuleAddr = pModules[nModule];
@@ -2307,21 +2529,9 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
                         continue;
                     }
 
-                    if (mName != NULL)
+                    if (seen.insert((DWORD_PTR)ModuleAddr).second)
                     {
-                        ArrayHolder<WCHAR> moduleName = new WCHAR[MAX_LONGPATH];
-                        FileNameForModule(&ModuleData, moduleName);
-
-                        int bytesWritten = WideCharToMultiByte(CP_ACP, 0, moduleName, -1, fileName, MAX_LONGPATH, NULL, NULL);
-                        _ASSERTE(bytesWritten > 0);
-                    }
-
-                    if ((mName == NULL) ||
-                        IsSameModuleName(fileName, mName) ||
-                        DebuggerModuleNamesMatch(ModuleData.PEAssembly, mName) ||
-                        IsFusionLoadedModule(fileName, mName))
-                    {
-                        AddToModuleList(moduleList, *numModule, maxList, (DWORD_PTR)ModuleAddr);
+                        m_modules.push_back((DWORD_PTR)ModuleAddr);
                     }
                 }
 
@@ -2331,12 +2541,129 @@ DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
         }
     }
 
+    m_populated = true;
+    return S_OK;
+}
+
+HRESULT ModuleNameIndex::PopulateNames()
+{
+    ArrayHolder<WCHAR> moduleName = new WCHAR[MAX_LONGPATH];
+    ArrayHolder<char> fileName = new char[MAX_LONGPATH];
+    CHAR debuggerName[MAX_LONGPATH+1];
+
+    m_fileNames.reserve(m_modules.size());
+    for (int i = 0; i < (int)m_modules.size(); i++)
+    {
+        if (IsInterrupt())
+        {
+            ExtOut("<interrupted>\n");
+            m_fileNames.clear();
+            m_byFileName.clear();
+            m_byDebuggerName.clear();
+            m_fusionNames.clear();
+            return E_ABORT;
+        }
+
+        fileName[0] = '\0';
+        DacpModuleData ModuleData;
+        if (SUCCEEDED(ModuleData.Request(g_sos, m_modules[i])))
+        {
+            FileNameForModule(&ModuleData, moduleName);
+
+            int bytesWritten = WideCharToMultiByte(CP_ACP, 0, moduleName, -1, fileName, MAX_LONGPATH, NULL, NULL);
+            _ASSERTE(bytesWritten > 0);
+
+            if (GetDebuggerModuleName(ModuleData.PEAssembly, debuggerName, ARRAY_SIZE(debuggerName)))
+            {
+                m_byDebuggerName[DebuggerNameKey(debuggerName)].push_back(i);
+            }
+        }
+        m_fileNames.push_back(fileName.GetPtr());
+        m_byFileName[FileNameKey(fileName)].push_back(i);
+        if (strchr(fileName, ',') != NULL)
+        {
+            m_fusionNames.push_back(i);
+        }
+    }
+
+    m_namesPopulated = true;
+    return S_OK;
+}
+
+DWORD_PTR *ModuleNameIndex::Find(__in_opt LPCSTR mName, int *numModule)
+{
+    if (!m_populated && FAILED(Populate()))
+    {
+        Clear();
+        return NULL;
+    }
+
+    std::vector<int> matches;
+    if (mName == NULL)
+    {
+        matches.resize(m_modules.size());
+        for (int i = 0; i < (int)matches.size(); i++)
+        {
+            matches[i] = i;
+        }
+    }
+    else
+    {
+        if (!m_namesPopulated && FAILED(PopulateNames()))
+        {
+            return NULL;
+        }
+
+        // The file name index only narrows down the candidates; IsSameModuleName
+        // also accepts a partial path.
+        auto found = m_byFileName.find(FileNameKey(mName));
+        if (found != m_byFileName.end())
+        {
+            for (int i : found->second)
+            {
+                if (IsSameModuleName(m_fileNames[i].c_str(), mName))
+                {
+                    matches.push_back(i);
+                }
+            }
+        }
+        AddMatches(m_byDebuggerName, DebuggerNameKey(mName), matches);
+        for (int i : m_fusionNames)
+        {
+            if (IsFusionLoadedModule(m_fileNames[i].c_str(), mName))
+            {
+                matches.push_back(i);
+            }
+        }
+
+        // Return the modules in the order they were enumerated like the full walk did
+        std::sort(matches.begin(), matches.end());
+        matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    }
+
+    DWORD_PTR *moduleList = new (std::nothrow) DWORD_PTR[matches.empty() ? 1 : matches.size()];
+    if (moduleList == NULL)
+    {
+        ReportOOM();
+        return NULL;
+    }
+    for (size_t i = 0; i < matches.size(); i++)
+    {
+        moduleList[i] = m_modules[matches[i]];
+    }
+    *numModule = (int)matches.size();
     return moduleList;
+}
+
+static ModuleNameIndex s_moduleNameIndex;
+
+DWORD_PTR *ModuleFromName(__in_opt LPSTR mName, int *numModule)
+{
+    if (numModule == NULL)
+        return NULL;
 
-    // We do not want to return a half-constructed list.  Instead, we return NULL on a failure.
-Failure:
-    delete [] moduleList;
-    return NULL;
+    *numModule = 0;
+    return s_moduleNameIndex.Find(mName, numModule);
 }
 
 #ifndef FEATURE_PAL
@@ -3035,7 +3362,7 @@ size_t FunctionType (size_t EIP)
 
     CLRDATA_ADDRESS dwStartAddr = TO_CDADDR(EIP);
     CLRDATA_ADDRESS pMD;
-    if (g_sos->GetMethodDescPtrFromIP(dwStartAddr, &pMD) != S_OK)
+    if (RequestMethodDescPtrFromIP(dwStartAddr, &pMD) != S_OK)
     {
         return 1;
     }
@@ -3638,15 +3965,83 @@ BOOL GetCMDOption(const char *string, CMDOption *option, size_t nOption,
 ReadVirtualCache g_special_rvCacheSpace;
 ReadVirtualCache *rvCache = &g_special_rvCacheSpace;
 
-void ResetGlobals(void)
+// The DAC instance state, the useful globals, the MethodTable cache and the read cache
+// are kept across commands as long as the target hasn't moved. The cache epoch is made of
+// the debugger's stop id, the current process and the DAC instance.
+static bool s_cacheEpochValid = false;
+static bool s_usefulGlobalsValid = false;
+static ULONG s_cacheStopId = 0;
+static ULONG s_cacheProcessId = 0;
+static IXCLRDataProcess* s_cacheClrData = nullptr;
+
+//---------------------------------------------------------------------------------------
+//
+// Discards all the SOS state cached across commands. The next command that loads the
+// DAC starts a new cache epoch and flushes the DAC instance.
+//
+void FlushSOSCaches()
 {
-    // There are some globals used in SOS that exist for efficiency in one command,
-    // but should be reset because the next execution of an SOS command could be on
-    // another managed process. Reset them to a default state here, as this command
-    // is called on every SOS entry point.
-    g_sos->GetUsefulGlobals(&g_special_usefulGlobals);
+    s_cacheEpochValid = false;
+    s_usefulGlobalsValid = false;
+    // The importers belong to the DAC instance so release them first
+    FlushMetadataCache();
+    if (s_cacheClrData != nullptr)
+    {
+        s_cacheClrData->Release();
+        s_cacheClrData = nullptr;
+    }
     g_special_mtCache.Clear();
     g_special_rvCacheSpace.Clear();
+    s_moduleNameIndex.Clear();
+    s_codeRangeCache.Clear();
+}
+
+//---------------------------------------------------------------------------------------
+//
+// Returns true if the state cached for this DAC instance is still valid. Otherwise all
+// the caches are discarded, a new epoch is started and false is returned.
+//
+static bool CheckCacheEpoch(IXCLRDataProcess* clrData)
+{
+    static bool registered = false;
+    if (!registered)
+    {
+        registered = true;
+        OnUnloadTask::Register(FlushSOSCaches);
+    }
+
+    ULONG stopId = 0;
+    ULONG processId = 0;
+    IDebuggerServices* debuggerServices = GetDebuggerServices();
+    if (debuggerServices != nullptr)
+    {
+        stopId = debuggerServices->GetStopId();
+        debuggerServices->GetCurrentProcessSystemId(&processId);
+    }
+
+    if (s_cacheEpochValid && s_cacheClrData == clrData && s_cacheStopId == stopId && s_cacheProcessId == processId)
+    {
+        return true;
+    }
+
+    FlushSOSCaches();
+    s_cacheEpochValid = true;
+    s_cacheStopId = stopId;
+    s_cacheProcessId = processId;
+    s_cacheClrData = clrData;
+    s_cacheClrData->AddRef();
+    return false;
+}
+
+void ResetGlobals(void)
+{
+    // The globals used in SOS for efficiency are only refreshed when the cache epoch
+    // changes (the target moved, the process changed or the DAC instance is different).
+    // This is called on every SOS entry point after LoadClrDebugDll.
+    if (!s_usefulGlobalsValid)
+    {
+        s_usefulGlobalsValid = SUCCEEDED(g_sos->GetUsefulGlobals(&g_special_usefulGlobals));
+    }
     Output::ResetIndent();
 }
 
@@ -3813,6 +4208,8 @@ HRESULT LoadClrDebugDll(void)
     HRESULT hr = g_pRuntime->GetClrDataProcess(IRuntime::ClrDataProcessFlags::UseCDac, &g_clrData);
     if (FAILED(hr))
     {
+        // The dbgeng instance is flushed every time so nothing can be kept across commands
+        FlushSOSCaches();
         g_clrData = GetClrDataFromDbgEng();
         if (g_clrData == nullptr)
         {
@@ -3822,7 +4219,12 @@ HRESULT LoadClrDebugDll(void)
     else
     {
         g_clrData->AddRef();
-        g_clrData->Flush();
+
+        // Only flush the DAC's caches when the target has moved since the last command
+        if (!CheckCacheEpoch(g_clrData))
+        {
+            g_clrData->Flush();
+        }
     }
     hr = g_clrData->QueryInterface(__uuidof(ISOSDacInterface), (void**)&g_sos);
     if (FAILED(hr))
@@ -3934,6 +4336,320 @@ BOOL GetGcStructuresValid()
     return heapData.bGcStructuresValid;
 }
 
+ReadVirtualCache::ReadVirtualCache(ULONG maxPages)
+    : m_pages(NULL), m_buckets(NULL), m_maxPages(maxPages), m_bucketMask(0),
+      m_usedPages(0), m_lruHead(-1), m_lruTail(-1)
+{
+}
+
+ReadVirtualCache::~ReadVirtualCache()
+{
+    Free();
+}
+
+void ReadVirtualCache::Free()
+{
+    delete [] m_pages;
+    delete [] m_buckets;
+    m_pages = NULL;
+    m_buckets = NULL;
+    m_bucketMask = 0;
+    m_usedPages = 0;
+    m_lruHead = m_lruTail = -1;
+}
+
+void ReadVirtualCache::Clear()
+{
+    if (m_buckets != NULL)
+    {
+        for (ULONG i = 0; i <= m_bucketMask; i++)
+        {
+            m_buckets[i] = -1;
+        }
+    }
+    m_usedPages = 0;
+    m_lruHead = m_lruTail = -1;
+}
+
+void ReadVirtualCache::SetMaxPages(ULONG maxPages)
+{
+    if (maxPages == 0)
+    {
+        maxPages = 1;
+    }
+    else if (maxPages > CACHE_MAX_PAGES)
+    {
+        maxPages = CACHE_MAX_PAGES;
+    }
+    Free();
+    m_maxPages = maxPages;
+}
+
+bool ReadVirtualCache::EnsureAllocated()
+{
+    if (m_pages != NULL)
+    {
+        return true;
+    }
+    if (m_maxPages == 0)
+    {
+        return false;
+    }
+
+    // Allow the page budget to be tuned without rebuilding SOS
+    char buffer[16];
+    DWORD length = GetEnvironmentVariableA("DOTNET_SOS_ReadCachePages", buffer, ARRAY_SIZE(buffer));
+    if (length > 0 && length < ARRAY_SIZE(buffer))
+    {
+        ULONG pages = strtoul(buffer, NULL, 0);
+        if (pages > 0 && pages <= CACHE_MAX_PAGES)
+        {
+            m_maxPages = pages;
+        }
+        else
+        {
+            ExtDbgOut("DOTNET_SOS_ReadCachePages %s out of range, using %d pages\n", buffer, CACHE_DEFAULT_PAGES);
+            m_maxPages = CACHE_DEFAULT_PAGES;
+        }
+    }
+    else if (m_maxPages > CACHE_MAX_PAGES)
+    {
+        m_maxPages = CACHE_DEFAULT_PAGES;
+    }
+
+    // Keep the hash table at least twice the number of pages so the chains stay short
+    ULONG bucketCount = 1;
+    while (bucketCount < m_maxPages * 2)
+    {
+        bucketCount <<= 1;
+    }
+
+    m_pages = new (std::nothrow) Page[m_maxPages];
+    m_buckets = new (std::nothrow) int[bucketCount];
+    if (m_pages == NULL || m_buckets == NULL)
+    {
+        Free();
+        // Don't try again; fall back to uncached reads
+        m_maxPages = 0;
+        return false;
+    }
+    m_bucketMask = bucketCount - 1;
+    Clear();
+    return true;
+}
+
+ULONG ReadVirtualCache::Bucket(TADDR start) const
+{
+    ULONG64 pageNumber = (ULONG64)start / CACHE_SIZE;
+    return (ULONG)((pageNumber * 0x9E3779B97F4A7C15ull) >> 32) & m_bucketMask;
+}
+
+void ReadVirtualCache::Unlink(int index)
+{
+    Page& page = m_pages[index];
+    if (page.lruPrev != -1)
+        m_pages[page.lruPrev].lruNext = page.lruNext;
+    else
+        m_lruHead = page.lruNext;
+
+    if (page.lruNext != -1)
+        m_pages[page.lruNext].lruPrev = page.lruPrev;
+    else
+        m_lruTail = page.lruPrev;
+}
+
+void ReadVirtualCache::LinkAtHead(int index)
+{
+    Page& page = m_pages[index];
+    page.lruPrev = -1;
+    page.lruNext = m_lruHead;
+    if (m_lruHead != -1)
+        m_pages[m_lruHead].lruPrev = index;
+    m_lruHead = index;
+    if (m_lruTail == -1)
+        m_lruTail = index;
+}
+
+void ReadVirtualCache::RemoveFromBucket(int index)
+{
+    int* link = &m_buckets[Bucket(m_pages[index].start)];
+    while (*link != -1)
+    {
+        if (*link == index)
+        {
+            *link = m_pages[index].hashNext;
+            return;
+        }
+        link = &m_pages[*link].hashNext;
+    }
+}
+
+// Returns the index of the cached page starting at "start" or -1
+int ReadVirtualCache::FindPage(TADDR start, ULONG bucket) const
+{
+    for (int index = m_buckets[bucket]; index != -1; index = m_pages[index].hashNext)
+    {
+        if (m_pages[index].start == start)
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+// Returns a free page or recycles the least recently used one. The page returned
+// isn't in the LRU list or in the hash table.
+int ReadVirtualCache::AllocatePage()
+{
+    if (m_usedPages < m_maxPages)
+    {
+        return m_usedPages++;
+    }
+    int index = m_lruTail;
+    Unlink(index);
+    RemoveFromBucket(index);
+    return index;
+}
+
+// Adds a page just read from the target to the cache or if nothing could be
+// read, puts it back at the end of the LRU list unhashed so it is reused first.
+bool ReadVirtualCache::CommitPage(int index, TADDR start, ULONG bucket, ULONG cbBytesRead)
+{
+    Page& page = m_pages[index];
+    if (cbBytesRead == 0)
+    {
+        page.start = (TADDR)0;
+        page.size = 0;
+        page.hashNext = -1;
+        page.lruPrev = m_lruTail;
+        page.lruNext = -1;
+        if (m_lruTail != -1)
+            m_pages[m_lruTail].lruNext = index;
+        m_lruTail = index;
+        if (m_lruHead == -1)
+            m_lruHead = index;
+        return false;
+    }
+
+    page.start = start;
+    page.size = cbBytesRead;
+    page.hashNext = m_buckets[bucket];
+    m_buckets[bucket] = index;
+    LinkAtHead(index);
+    return true;
+}
+
+// Returns the cached page starting at the page aligned address "start", reading it from
+// the target on a miss. Returns NULL if nothing at all could be read from that page.
+ReadVirtualCache::Page* ReadVirtualCache::GetPage(TADDR start)
+{
+    ULONG bucket = Bucket(start);
+    int index = FindPage(start, bucket);
+    if (index != -1)
+    {
+        if (index != m_lruHead)
+        {
+            Unlink(index);
+            LinkAtHead(index);
+        }
+        return &m_pages[index];
+    }
+
+    index = AllocatePage();
+    ULONG cbBytesRead = 0;
+    HRESULT hr = g_ExtData->ReadVirtual(TO_CDADDR(start), m_pages[index].data, CACHE_SIZE, &cbBytesRead);
+    PerfCountRead(hr, cbBytesRead);
+    if (hr != S_OK)
+    {
+        cbBytesRead = 0;
+    }
+    return CommitPage(index, start, bucket, cbBytesRead) ? &m_pages[index] : NULL;
+}
+
+// Loads the pages holding the "size" bytes at each of the addresses that aren't already
+// cached with as few debugger round trips as possible. Used by the loops that chase many
+// unrelated pointers (array elements, handles, sync blocks) before they MOVE from them.
+void ReadVirtualCache::Prefetch(const TADDR* addresses, ULONG count, ULONG size)
+{
+    if (addresses == NULL || count == 0 || size == 0 || size > CACHE_SIZE || !EnsureAllocated())
+        return;
+
+    // Don't prefetch more than half of the cache at a time so a batch doesn't evict itself
+    const ULONG MaxBatch = 64;
+    ULONG maxBatch = _min(MaxBatch, _max(m_maxPages / 2, (ULONG)1));
+
+    READ_VIRTUAL_REQUEST requests[MaxBatch];
+    int indexes[MaxBatch];
+    ULONG batch = 0;
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        TADDR address = addresses[i];
+        if (address == 0 || (address + size) < address)
+            continue;
+
+        // The object may straddle two pages
+        TADDR firstPage = address & ~((TADDR)CACHE_SIZE - 1);
+        TADDR lastPage = (address + size - 1) & ~((TADDR)CACHE_SIZE - 1);
+        for (TADDR start = firstPage; ; start += CACHE_SIZE)
+        {
+            bool queued = FindPage(start, Bucket(start)) != -1;
+            for (ULONG j = 0; j < batch && !queued; j++)
+            {
+                queued = requests[j].offset == TO_CDADDR(start);
+            }
+            if (!queued)
+            {
+                int index = AllocatePage();
+                requests[batch].offset = TO_CDADDR(start);
+                requests[batch].buffer = m_pages[index].data;
+                requests[batch].bufferSize = CACHE_SIZE;
+                requests[batch].bytesRead = 0;
+                indexes[batch] = index;
+                if (++batch == maxBatch)
+                {
+                    FillPages(requests, indexes, batch);
+                    batch = 0;
+                }
+            }
+            if (start == lastPage)
+                break;
+        }
+    }
+    if (batch > 0)
+    {
+        FillPages(requests, indexes, batch);
+    }
+}
+
+void ReadVirtualCache::FillPages(PREAD_VIRTUAL_REQUEST requests, const int* indexes, ULONG count)
+{
+    if (FAILED(ReadVirtualBatch(requests, count)))
+    {
+        for (ULONG i = 0; i < count; i++)
+        {
+            requests[i].bytesRead = 0;
+        }
+    }
+    for (ULONG i = 0; i < count; i++)
+    {
+        TADDR start = TO_TADDR(requests[i].offset);
+        CommitPage(indexes[i], start, Bucket(start), requests[i].bytesRead);
+    }
+}
+
+HRESULT ReadVirtualCache::UncachedRead(TADDR address, PVOID buffer, ULONG bufferSize, PULONG lpcbBytesRead)
+{
+    ULONG cbBytesRead = 0;
+    HRESULT hr = g_ExtData->ReadVirtual(TO_CDADDR(address), buffer, bufferSize, &cbBytesRead);
+    PerfCountRead(hr, cbBytesRead);
+    if (lpcbBytesRead != NULL)
+    {
+        *lpcbBytesRead = cbBytesRead;
+    }
+    return hr;
+}
+
 HRESULT ReadVirtualCache::Read(TADDR address, PVOID buffer, ULONG bufferSize, PULONG lpcbBytesRead)
 {
     // address can be any random ULONG64, as it can come from VerifyObjectMember(), and this
@@ -3942,51 +4658,211 @@ HRESULT ReadVirtualCache::Read(TADDR address, PVOID buffer, ULONG bufferSize, PU
     if (bufferSize == 0)
         return S_OK;
 
-    if (bufferSize > CACHE_SIZE)
+    if (bufferSize > CACHE_SIZE || (address + bufferSize) < address || !EnsureAllocated())
     {
         // Don't even try with the cache
-        return g_ExtData->ReadVirtual(TO_CDADDR(address), buffer, bufferSize, lpcbBytesRead);
+        return UncachedRead(address, buffer, bufferSize, lpcbBytesRead);
     }
 
-    if (!m_cacheValid || (address < m_startCache) || (address > (m_startCache + m_cacheSize - bufferSize)))
-    {
-        ULONG cbBytesRead = 0;
-
-        m_cacheValid = FALSE;
-        m_startCache = address;
+    g_perfCounters.cacheReads++;
+    ULONG64 readCalls = g_perfCounters.readCalls;
 
-        // Avoid an int overflow
-        if (m_startCache + CACHE_SIZE < m_startCache)
-            m_startCache = (TADDR)(-CACHE_SIZE);
+    // The request spans at most two pages
+    ULONG copied = 0;
+    while (copied < bufferSize)
+    {
+        TADDR current = address + copied;
+        TADDR start = current & ~((TADDR)CACHE_SIZE - 1);
+        Page* page = GetPage(start);
+        ULONG offset = (ULONG)(current - start);
+        if (page == NULL || offset >= page->size)
+        {
+            break;
+        }
+        ULONG size = _min(bufferSize - copied, page->size - offset);
+        memcpy((BYTE*)buffer + copied, page->data + offset, size);
+        copied += size;
 
-        HRESULT hr = g_ExtData->ReadVirtual(TO_CDADDR(m_startCache), m_cache, CACHE_SIZE, &cbBytesRead);
-        if (hr != S_OK)
+        // A short page means the rest of it isn't readable
+        if (page->size < CACHE_SIZE)
         {
-            return hr;
+            break;
         }
+    }
 
-        m_cacheSize = cbBytesRead;
-        m_cacheValid = TRUE;
+    if (copied < bufferSize)
+    {
+        // Let the debugger decide how much of a partially readable range to return
+        return UncachedRead(address, buffer, bufferSize, lpcbBytesRead);
     }
 
-    // If the address is within the cache, copy the cached memory to the input buffer
-    LONG_PTR cacheOffset = address - m_startCache;
-    if (cacheOffset >= 0 && cacheOffset < CACHE_SIZE)
+    if (g_perfCounters.readCalls == readCalls)
+    {
+        g_perfCounters.cacheHits++;
+    }
+
+    if (lpcbBytesRead != NULL)
+    {
+        *lpcbBytesRead = copied;
+    }
+    return S_OK;
+}
+
+//---------------------------------------------------------------------------------------
+//
+// Reads a group of target memory ranges. When SOS is loaded by a native debugger the
+// requests are handed to it in one call so it can merge adjacent ranges; otherwise they
+// are read one at a time. Returns S_OK if every request was completely read, S_FALSE if
+// any came up short (see each request's bytesRead).
+//
+HRESULT ReadVirtualBatch(PREAD_VIRTUAL_REQUEST requests, ULONG count)
+{
+    if (requests == NULL)
+        return E_INVALIDARG;
+
+    IDebuggerServices* debuggerServices = GetDebuggerServices();
+    if (debuggerServices != NULL)
     {
-        int size = _min(bufferSize, m_cacheSize);
-        memcpy(buffer, (LPVOID)(m_cache + cacheOffset), size);
+        HRESULT hr = debuggerServices->ReadVirtualBatch(requests, count);
+        ULONG bytesRead = 0;
+        for (ULONG i = 0; SUCCEEDED(hr) && i < count; i++)
+        {
+            bytesRead += requests[i].bytesRead;
+        }
+        PerfCountRead(hr, bytesRead);
+        return hr;
+    }
 
-        if (lpcbBytesRead != NULL)
+    HRESULT result = S_OK;
+    for (ULONG i = 0; i < count; i++)
+    {
+        ULONG bytesRead = 0;
+        HRESULT hr = g_ExtData->ReadVirtual(requests[i].offset, requests[i].buffer, requests[i].bufferSize, &bytesRead);
+        PerfCountRead(hr, bytesRead);
+        if (FAILED(hr))
         {
-            *lpcbBytesRead = size;
+            bytesRead = 0;
+        }
+        requests[i].bytesRead = bytesRead;
+        if (bytesRead < requests[i].bufferSize)
+        {
+            result = S_FALSE;
         }
     }
-    else
+    return result;
+}
+
+PerfCounters g_perfCounters;
+
+static PerfCounters s_perfLastCommand;
+static PerfCounters s_perfSession;
+static char s_perfLastCommandName[64];
+static ULONG s_perfSessionCommands = 0;
+static int s_perfDepth = 0;
+static bool s_perfTracking = false;
+static LARGE_INTEGER s_perfStart;
+static MEMORY_READ_STATISTICS s_perfDebuggerStart;
+
+static bool GetDebuggerReadStatistics(MEMORY_READ_STATISTICS* statistics)
+{
+    IDebuggerServices* debuggerServices = GetDebuggerServices();
+    return debuggerServices != nullptr && SUCCEEDED(debuggerServices->GetMemoryReadStatistics(statistics));
+}
+
+//---------------------------------------------------------------------------------------
+//
+// Starts collecting the counters for a command. Called for every command invocation
+// by INIT_API_EXT; nested invocations are part of the outer command. sosstatus isn't
+// counted so "sosstatus -perf" reports the command before it.
+//
+void PerfBeginCommand(const char* name)
+{
+    if (s_perfDepth++ > 0)
+        return;
+
+    s_perfTracking = _stricmp(name, "SOSStatus") != 0;
+    if (!s_perfTracking)
+        return;
+
+    ZeroMemory(&g_perfCounters, sizeof(g_perfCounters));
+    strncpy_s(s_perfLastCommandName, ARRAY_SIZE(s_perfLastCommandName), name, _TRUNCATE);
+    if (!GetDebuggerReadStatistics(&s_perfDebuggerStart))
     {
-        return E_FAIL;
+        ZeroMemory(&s_perfDebuggerStart, sizeof(s_perfDebuggerStart));
     }
+    QueryPerformanceCounter(&s_perfStart);
+}
 
-    return S_OK;
+void PerfEndCommand()
+{
+    if (--s_perfDepth > 0 || !s_perfTracking)
+        return;
+
+    LARGE_INTEGER end, frequency;
+    QueryPerformanceCounter(&end);
+    QueryPerformanceFrequency(&frequency);
+    if (frequency.QuadPart > 0)
+    {
+        g_perfCounters.elapsedMicroseconds = (ULONG64)((end.QuadPart - s_perfStart.QuadPart) * 1000000.0 / frequency.QuadPart);
+    }
+
+    MEMORY_READ_STATISTICS statistics;
+    if (GetDebuggerReadStatistics(&statistics))
+    {
+        g_perfCounters.debuggerReadCalls = statistics.readCalls - s_perfDebuggerStart.readCalls;
+        g_perfCounters.debuggerBytesRead = statistics.bytesRead - s_perfDebuggerStart.bytesRead;
+        g_perfCounters.debuggerFailedReads = statistics.failedReads - s_perfDebuggerStart.failedReads;
+    }
+
+    s_perfLastCommand = g_perfCounters;
+    s_perfSession.readCalls += g_perfCounters.readCalls;
+    s_perfSession.bytesRead += g_perfCounters.bytesRead;
+    s_perfSession.failedReads += g_perfCounters.failedReads;
+    s_perfSession.cacheReads += g_perfCounters.cacheReads;
+    s_perfSession.cacheHits += g_perfCounters.cacheHits;
+    s_perfSession.dacTargetReads += g_perfCounters.dacTargetReads;
+    s_perfSession.debuggerReadCalls += g_perfCounters.debuggerReadCalls;
+    s_perfSession.debuggerBytesRead += g_perfCounters.debuggerBytesRead;
+    s_perfSession.debuggerFailedReads += g_perfCounters.debuggerFailedReads;
+    s_perfSession.elapsedMicroseconds += g_perfCounters.elapsedMicroseconds;
+    s_perfSessionCommands++;
+    s_perfTracking = false;
+}
+
+static void DisplayPerfCounters(const PerfCounters& counters)
+{
+    ExtOut("    Wall time:          %I64u.%03u ms\n", counters.elapsedMicroseconds / 1000, (ULONG)(counters.elapsedMicroseconds % 1000));
+    ExtOut("    Reads:              %I64u (%I64u bytes, %I64u failed)\n", counters.readCalls, counters.bytesRead, counters.failedReads);
+    ExtOut("    Read cache:         %I64u of %I64u hits", counters.cacheHits, counters.cacheReads);
+    if (counters.cacheReads > 0)
+    {
+        ExtOut(" (%2.1f%%)", 100.0 * counters.cacheHits / counters.cacheReads);
+    }
+    ExtOut("\n");
+    ExtOut("    DAC target reads:   %I64u\n", counters.dacTargetReads);
+    if (counters.debuggerReadCalls > 0)
+    {
+        ExtOut("    Debugger reads:     %I64u (%I64u bytes, %I64u failed)\n", counters.debuggerReadCalls, counters.debuggerBytesRead, counters.debuggerFailedReads);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//
+// Displays the counters of the last command and the totals for the session. The "Reads"
+// are the ones SOS itself sends to the debugger; under lldb the "Debugger reads" include
+// everything read on the command's behalf, i.e. the DAC reads when SOS is hosted.
+//
+void DisplayPerfCounters()
+{
+    if (s_perfSessionCommands == 0)
+    {
+        ExtOut("No commands have run yet\n");
+        return;
+    }
+    ExtOut("Last command: %s\n", s_perfLastCommandName);
+    DisplayPerfCounters(s_perfLastCommand);
+    ExtOut("Session (%u commands):\n", s_perfSessionCommands);
+    DisplayPerfCounters(s_perfSession);
 }
 
 HRESULT GetMTOfObject(TADDR obj, TADDR *mt)
@@ -5178,14 +6054,14 @@ WString MethodNameFromIP(CLRDATA_ADDRESS ip, BOOL bSuppressLines, BOOL bAssembly
     WString methodOutput;
     CLRDATA_ADDRESS mdesc = 0;
 
-    if (FAILED(g_sos->GetMethodDescPtrFromIP(ip, &mdesc)))
+    if (FAILED(RequestMethodDescPtrFromIP(ip, &mdesc)))
     {
         methodOutput = W("<unknown>");
     }
     else
     {
         DacpMethodDescData mdescData;
-        if (SUCCEEDED(g_sos->GetMethodDescName(mdesc, mdNameLen, g_mdName, NULL)))
+        if (SUCCEEDED(RequestMethodDescName(mdesc, mdNameLen, g_mdName)))
         {
             if (bAssemblyName)
             {
@@ -1219,6 +1219,12 @@ HRESULT FileNameForModule (const DacpModuleData * const pModule, __out_ecount (M
 HRESULT FileNameForModule (DWORD_PTR pModuleAddr, __out_ecount (MAX_LONGPATH) WCHAR *fileName);
 void IP2MethodDesc (DWORD_PTR IP, DWORD_PTR &methodDesc, JITTypes &jitType,
                     DWORD_PTR &gcinfoAddr);
+
+// The DAC IP lookups the stack commands make, cached for the current stop
+HRESULT RequestCodeHeaderData(CLRDATA_ADDRESS ip, DacpCodeHeaderData* pCodeHeaderData);
+HRESULT RequestMethodDescPtrFromIP(CLRDATA_ADDRESS ip, CLRDATA_ADDRESS* pMD);
+HRESULT RequestMethodDescName(CLRDATA_ADDRESS md, ULONG32 count, __out_ecount(count) WCHAR* name);
+
 const char *ElementTypeName (unsigned type);
 void DisplayFields (CLRDATA_ADDRESS cdaMT, DacpMethodTableData *pMTD, DacpMethodTableFieldData *pMTFD,
                     DWORD_PTR dwStartAddr = 0, BOOL bFirst=TRUE, BOOL bValueClass=FALSE);
@@ -1392,6 +1398,7 @@ BOOL IsMiniDumpFile();
 void ReportOOM();
 
 BOOL SafeReadMemory (TADDR offset, PVOID lpBuffer, ULONG cb, PULONG lpcbBytesRead);
+HRESULT ReadVirtualBatch (PREAD_VIRTUAL_REQUEST requests, ULONG count);
 BOOL NameForMD_s (DWORD_PTR pMD, __out_ecount (capacity_mdName) WCHAR *mdName, size_t capacity_mdName);
 BOOL NameForMT_s (DWORD_PTR MTAddr, __out_ecount (capacity_mdName) WCHAR *mdName, size_t capacity_mdName);
 
@@ -1411,24 +1418,32 @@ extern DacpUsefulGlobalsData g_special_usefulGlobals;
 class HeapStat
 {
 protected:
-    struct Node
+    struct Entry
     {
-        DWORD_PTR data;
-        DWORD count;
+        DWORD_PTR data;     // The key: a MethodTable or an interned string
+        ULONG hash;
+        DWORD count;        // 0 for a free slot
         size_t totalSize;
-        Node* left;
-        Node* right;
-        Node ()
-            : data(0), count(0), totalSize(0), left(NULL), right(NULL)
-        {
-        }
     };
+
+    // String keys are copied into large blocks instead of an allocation per key
+    struct StringBlock
+    {
+        StringBlock* next;
+        size_t used;
+        size_t capacity;
+        WCHAR data[1];
+    };
+
     BOOL bHasStrings;
-    Node *head;
-    BOOL fLinear;
+    Entry* entries;         // Open addressing hash table; after Sort the sorted entries
+    ULONG capacity;         // Power of 2
+    ULONG count;
+    BOOL fSorted;
+    StringBlock* strings;
 public:
     HeapStat ()
-        : bHasStrings(FALSE), head(NULL), fLinear(FALSE)
+        : bHasStrings(FALSE), entries(NULL), capacity(0), count(0), fSorted(FALSE), strings(NULL)
     {}
     ~HeapStat()
     {
@@ -1445,11 +1460,11 @@ public:
             bHasStrings = abHasStrings;
         }
 private:
-    int CompareData(DWORD_PTR n1, DWORD_PTR n2);
-    void SortAdd (Node *&root, Node *entry);
-    void LinearAdd (Node *&root, Node *entry);
-    void ReverseLeftMost (Node *root);
-    void Linearize();
+    ULONG Hash(DWORD_PTR aData);
+    BOOL Grow();
+    WCHAR* InternString(const WCHAR* str);
+    static int __cdecl CompareEntries(const void* e1, const void* e2);
+    static int __cdecl CompareStringEntries(const void* e1, const void* e2);
 };
 
 class CGCDesc;
@@ -1473,28 +1488,35 @@ class MethodTableCache
 {
 protected:
 
-    struct Node
+    struct Entry
     {
         DWORD_PTR data;            // This is the key (the method table pointer)
-        MethodTableInfo info;  // The info associated with this MethodTable
-        Node* left;
-        Node* right;
-        Node (DWORD_PTR aData) : data(aData), left(NULL), right(NULL)
-        {
-            info.BaseSize = 0;
-            info.ComponentSize = 0;
-            info.bContainsPointers = false;
-            info.bCollectible = false;
-            info.GCInfo = NULL;
-            info.ArrayOfVC = false;
-            info.GCInfoBuffer = NULL;
-            info.LoaderAllocatorObjectHandle = (TADDR)0;
-        }
+        MethodTableInfo info;      // The info associated with this MethodTable
     };
-    Node *head;
+
+    // Entries are carved out of fixed size blocks so the MethodTableInfo pointers
+    // handed out by Lookup stay valid when the hash table grows.
+    struct EntryBlock
+    {
+        EntryBlock* next;
+        ULONG used;
+        Entry entries[1];
+    };
+
+    struct Slot
+    {
+        DWORD_PTR data;
+        Entry* entry;              // NULL if the slot is empty
+    };
+
+    Slot* table;
+    ULONG capacity;                // Always a power of 2
+    ULONG count;
+    EntryBlock* entryBlocks;
+
 public:
     MethodTableCache ()
-        : head(NULL)
+        : table(NULL), capacity(0), count(0), entryBlocks(NULL)
     {}
     ~MethodTableCache() { Clear(); }
 
@@ -1504,8 +1526,9 @@ public:
 
     void Clear ();
 private:
-    int CompareData(DWORD_PTR n1, DWORD_PTR n2);
-    void ReverseLeftMost (Node *root);
+    static ULONG Hash(DWORD_PTR aData);
+    BOOL Grow();
+    Entry* AllocateEntry(DWORD_PTR aData);
 };
 
 extern MethodTableCache g_special_mtCache;
@@ -1682,10 +1705,12 @@ inline BOOL IsKernelDebugger ()
 }
 
 void    ResetGlobals(void);
+void    FlushSOSCaches();
 HRESULT LoadClrDebugDll(void);
 
 extern IMetaDataImport* MDImportForModule (DacpModuleData *pModule);
 extern IMetaDataImport* MDImportForModule (DWORD_PTR pModule);
+void FlushMetadataCache();
 
 //*****************************************************************************
 //
@@ -1997,12 +2022,18 @@ public:
         if (mPage == NULL)
             return MisalignedRead(addr, t);
 
+        g_perfCounters.cacheReads++;
+
         // Is addr on the current page?  If not read the page of memory addr is on.
         // If this fails, we will fall back to a raw read out of the process (which
         // is what MisalignedRead does).
+        bool hit = true;
         if ((addr < mCurrPageStart) || (addr - mCurrPageStart > mCurrPageSize))
+        {
             if (!update || !MoveToPage(addr))
                 return MisalignedRead(addr, t);
+            hit = false;
+        }
 
         // If MoveToPage succeeds, we MUST be on the right page.
         _ASSERTE(addr >= mCurrPageStart);
@@ -2015,9 +2046,9 @@ public:
 
         // If we reach here we know we are on the right page of memory in the cache, and
         // that the read won't fall off of the end of the page.
-#ifdef _DEBUG
         mReads++;
-#endif
+        if (hit)
+            g_perfCounters.cacheHits++;
 
         *t = *reinterpret_cast<T*>(mPage+offset);
         return true;
@@ -2038,6 +2069,7 @@ public:
             // Read into the middle of the buffer, update current page size.
             ULONG read = 0;
             HRESULT hr = g_ExtData->ReadVirtual(mCurrPageStart+mCurrPageSize, mPage+mCurrPageSize, total, &read);
+            PerfCountRead(hr, read);
             mCurrPageSize += read;
 
             if (hr != S_OK)
@@ -2054,22 +2086,19 @@ public:
 
     void ClearStats()
     {
-#ifdef _DEBUG
         mMisses = 0;
         mReads = 0;
         mMisaligned = 0;
-#endif
     }
 
+    // The counters are kept in all builds (they also feed "sosstatus -perf")
     void PrintStats(const char *func)
     {
-#ifdef _DEBUG
         char buffer[1024];
         sprintf_s(buffer, ARRAY_SIZE(buffer), "Cache (%s): %d reads (%2.1f%% hits), %d misses (%2.1f%%), %d misaligned (%2.1f%%).\n",
                                              func, mReads, 100*(mReads-mMisses)/(float)(mReads+mMisaligned), mMisses,
                                              100*mMisses/(float)(mReads+mMisaligned), mMisaligned, 100*mMisaligned/(float)(mReads+mMisaligned));
         OutputDebugStringA(buffer);
-#endif
     }
 
 private:
@@ -2086,6 +2115,7 @@ private:
     {
         ULONG fetched = 0;
         HRESULT hr = g_ExtData->ReadVirtual(addr, (BYTE*)t, sizeof(T), &fetched);
+        PerfCountRead(hr, fetched);
 
         if (FAILED(hr) || fetched != sizeof(T))
             return false;
@@ -12,6 +12,30 @@ extern "C" {
 
 typedef bool (*PEXECUTE_COMMAND_OUTPUT_CALLBACK)(ULONG mask, const char *text);
 
+/// <summary>
+/// One entry of a IDebuggerServices::ReadVirtualBatch request. The caller fills in the
+/// address, buffer and size; the debugger returns the number of bytes read in bytesRead.
+/// </summary>
+typedef struct _READ_VIRTUAL_REQUEST
+{
+    ULONG64 offset;
+    PVOID buffer;
+    ULONG bufferSize;
+    ULONG bytesRead;
+} READ_VIRTUAL_REQUEST, *PREAD_VIRTUAL_REQUEST;
+
+/// <summary>
+/// The debugger's memory read counters displayed by sosstatus.
+/// </summary>
+typedef struct _MEMORY_READ_STATISTICS
+{
+    ULONG unreadableRanges;     // number of known unreadable ranges for the current stop
+    ULONG64 unreadableHits;     // reads failed or shortened without asking the debugger
+    ULONG64 readCalls;          // ReadVirtual calls since the debugger services were created
+    ULONG64 bytesRead;
+    ULONG64 failedReads;
+} MEMORY_READ_STATISTICS, *PMEMORY_READ_STATISTICS;
+
 /// <summary>
 /// IDebuggerServices 
 /// 
@@ -198,6 +222,22 @@ public:
 
     virtual HRESULT STDMETHODCALLTYPE GetDacSignatureVerificationSettings(
         BOOL* dacSignatureVerificationEnabled) = 0;
+
+    // Returns an id that changes every time the target has been continued (moved)
+    // since the last FlushCheck. Used to decide how long cached target state is valid.
+    virtual ULONG STDMETHODCALLTYPE GetStopId() = 0;
+
+    virtual HRESULT STDMETHODCALLTYPE GetMemoryReadStatistics(
+        PMEMORY_READ_STATISTICS statistics) = 0;
+
+    /// <summary>
+    /// Reads a group of target memory ranges in one call so the debugger can sort and
+    /// merge adjacent ranges. Returns S_OK if every request was completely read, S_FALSE
+    /// if any was partially or not read at all (see each request's bytesRead).
+    /// </summary>
+    virtual HRESULT STDMETHODCALLTYPE ReadVirtualBatch(
+        PREAD_VIRTUAL_REQUEST requests,
+        ULONG count) = 0;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,177 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+#include <algorithm>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <elf.h>
+#endif
+#include "elfcorefile.h"
+
+ElfCoreFile::ElfCoreFile() :
+    m_base(nullptr),
+    m_size(0)
+{
+}
+
+ElfCoreFile::~ElfCoreFile()
+{
+    Close();
+}
+
+bool
+ElfCoreFile::Open(const char* path)
+{
+    Close();
+#if defined(__linux__)
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Elf64_Ehdr) || (uint64_t)st.st_size > SIZE_MAX)
+    {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return false;
+    }
+    m_base = (uint8_t*)base;
+    m_size = (size_t)st.st_size;
+    m_path = path;
+
+    if (!ParseSegments())
+    {
+        Close();
+        return false;
+    }
+    // The reads mostly hop around; don't let the kernel read ahead large chunks
+    madvise(m_base, m_size, MADV_RANDOM);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+ElfCoreFile::Close()
+{
+    if (m_base != nullptr)
+    {
+        munmap(m_base, m_size);
+        m_base = nullptr;
+    }
+    m_size = 0;
+    m_path.clear();
+    m_segments.clear();
+}
+
+#if defined(__linux__)
+
+template <typename Ehdr, typename Phdr>
+bool
+ElfCoreFile::AddLoadSegments()
+{
+    const Ehdr* ehdr = (const Ehdr*)m_base;
+    if (ehdr->e_type != ET_CORE || ehdr->e_phentsize != sizeof(Phdr) || ehdr->e_phnum == 0)
+    {
+        return false;
+    }
+    uint64_t phoff = ehdr->e_phoff;
+    if (phoff > m_size || ((uint64_t)ehdr->e_phnum * sizeof(Phdr)) > (m_size - phoff))
+    {
+        return false;
+    }
+    const Phdr* phdrs = (const Phdr*)(m_base + phoff);
+    m_segments.reserve(ehdr->e_phnum);
+    for (int i = 0; i < ehdr->e_phnum; i++)
+    {
+        const Phdr& phdr = phdrs[i];
+        if (phdr.p_type != PT_LOAD || phdr.p_filesz == 0 || phdr.p_offset >= m_size)
+        {
+            continue;
+        }
+        // Only index the part of the segment that is actually in the file
+        uint64_t fileSize = std::min<uint64_t>(phdr.p_filesz, std::min<uint64_t>(phdr.p_memsz, m_size - phdr.p_offset));
+        if (fileSize == 0 || fileSize > UINT64_MAX - phdr.p_vaddr)
+        {
+            continue;
+        }
+        Segment segment;
+        segment.start = phdr.p_vaddr;
+        segment.end = phdr.p_vaddr + fileSize;
+        segment.fileOffset = phdr.p_offset;
+        m_segments.push_back(segment);
+    }
+    return !m_segments.empty();
+}
+
+#endif // __linux__
+
+bool
+ElfCoreFile::ParseSegments()
+{
+#if defined(__linux__)
+    const unsigned char* ident = m_base;
+    if (memcmp(ident, ELFMAG, SELFMAG) != 0 || ident[EI_DATA] != ELFDATA2LSB)
+    {
+        return false;
+    }
+    bool result = false;
+    if (ident[EI_CLASS] == ELFCLASS64)
+    {
+        result = AddLoadSegments<Elf64_Ehdr, Elf64_Phdr>();
+    }
+    else if (ident[EI_CLASS] == ELFCLASS32)
+    {
+        result = AddLoadSegments<Elf32_Ehdr, Elf32_Phdr>();
+    }
+    if (!result)
+    {
+        return false;
+    }
+    std::sort(m_segments.begin(), m_segments.end(),
+        [](const Segment& a, const Segment& b) { return a.start < b.start; });
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t
+ElfCoreFile::Read(uint64_t address, void* buffer, size_t size) const
+{
+    size_t bytesRead = 0;
+    if (m_base == nullptr || size == 0)
+    {
+        return 0;
+    }
+    // Find the last segment starting at or below the address
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), address,
+        [](uint64_t value, const Segment& segment) { return value < segment.start; });
+    if (it == m_segments.begin())
+    {
+        return 0;
+    }
+    --it;
+
+    // Copy across adjacent segments as long as the range stays backed by the core
+    while (bytesRead < size && it != m_segments.end() && address >= it->start && address < it->end)
+    {
+        size_t available = (size_t)std::min<uint64_t>(it->end - address, size - bytesRead);
+        memcpy((uint8_t*)buffer + bytesRead, m_base + it->fileOffset + (address - it->start), available);
+        bytesRead += available;
+        address += available;
+        ++it;
+    }
+    return bytesRead;
+}
@@ -0,0 +1,51 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Memory mapped ELF core file used by LLDBServices::ReadVirtual to serve reads straight
+// from the PT_LOAD segments of the core without going through the lldb SB APIs. Only the
+// file backed part (p_filesz) of each segment is served; everything else (for example
+// the file backed mappings of modules not saved in the core) is left to lldb.
+class ElfCoreFile
+{
+private:
+    struct Segment
+    {
+        uint64_t start;         // p_vaddr
+        uint64_t end;           // p_vaddr + p_filesz
+        uint64_t fileOffset;    // p_offset
+    };
+
+    std::string m_path;
+    uint8_t* m_base;
+    size_t m_size;
+    std::vector<Segment> m_segments;    // sorted by start address
+
+    bool ParseSegments();
+    template <typename Ehdr, typename Phdr> bool AddLoadSegments();
+
+public:
+    ElfCoreFile();
+    ~ElfCoreFile();
+
+    // Maps the core file and builds the segment index. Returns false if the file
+    // isn't an ELF core or can't be mapped.
+    bool Open(const char* path);
+
+    void Close();
+
+    bool IsOpen() const { return m_base != nullptr; }
+
+    const std::string& GetPath() const { return m_path; }
+
+    // Copies the bytes at [address, address + size) that are present in the core
+    // into buffer. Returns the number of contiguous bytes copied starting at address;
+    // 0 if the address isn't backed by the core file.
+    size_t Read(uint64_t address, void* buffer, size_t size) const;
+};
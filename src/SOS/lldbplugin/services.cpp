@@ -39,10 +39,15 @@ LLDBServices::LLDBServices(lldb::SBDebugger debugger) :
     m_processId(0),
     m_threadInfoInitialized(false),
     m_currentResult(nullptr),
-    m_sectionCacheStopId(UINT32_MAX)
+    m_sectionCacheStopId(UINT32_MAX),
+    m_coreFileProcessId(UINT32_MAX),
+    m_unreadableStopId(UINT32_MAX),
+    m_unreadableProcessId(UINT32_MAX),
+    m_unreadableHits(0),
+    m_readCalls(0),
+    m_bytesRead(0),
+    m_failedReads(0)
 {
-    ClearCache();
-
     lldb::SBProcess process = GetCurrentProcess();
     if (process.IsValid())
     {
@@ -804,11 +809,44 @@ LLDBServices::ReadVirtual(
         goto exit;
     }
 
-    // Try the full read and return if successful
-    bytesRead = process.ReadMemory(offset, buffer, bufferSize, error);
-    if (error.Success())
+    // For ELF core dumps serve the read straight from the memory mapped core file. If
+    // any part of it isn't in the core, fall back to lldb for the whole read.
     {
-        goto exit;
+        ElfCoreFile* coreFile = GetCoreFile(process);
+        if (coreFile != nullptr)
+        {
+            bytesRead = coreFile->Read(offset, buffer, bufferSize);
+            if (bytesRead == bufferSize)
+            {
+                goto exit;
+            }
+            bytesRead = 0;
+        }
+    }
+
+    // Fail reads that start in memory already known to be unreadable right away and
+    // don't bother with the full read if the range runs into it.
+    {
+        EnsureUnreadableRanges(process);
+        uint64_t unreadableStart;
+        if (FindUnreadableRange(offset, bufferSize, unreadableStart))
+        {
+            m_unreadableHits++;
+            if (unreadableStart <= offset)
+            {
+                goto exit;
+            }
+            bufferSize = (ULONG)(unreadableStart - offset);
+        }
+        else
+        {
+            // Try the full read and return if successful
+            bytesRead = process.ReadMemory(offset, buffer, bufferSize, error);
+            if (error.Success())
+            {
+                goto exit;
+            }
+        }
     }
 
     // As it turns out the lldb ReadMemory API doesn't do partial reads and the SOS
@@ -852,10 +890,22 @@ LLDBServices::ReadVirtual(
             {
                 bytesRead += sectionBytesRead;
             }
+            else
+            {
+                // Remember the page that stopped the read so the next read into it fails fast
+                uint64_t pageStart = offset & PAGE_MASK;
+                AddUnreadableRange(target, pageStart, pageStart + PAGE_SIZE);
+            }
         }
     }
 
 exit:
+    m_readCalls++;
+    m_bytesRead += bytesRead;
+    if (bytesRead == 0)
+    {
+        m_failedReads++;
+    }
     if (pbytesRead)
     {
         *pbytesRead = bytesRead;
@@ -863,6 +913,244 @@ exit:
     return bytesRead > 0 ? S_OK : E_FAIL;
 }
 
+// Requests closer than this are read together with the bytes in between
+#define BATCH_MERGE_GAP PAGE_SIZE
+
+// Upper limit on the size of a merged read
+#define BATCH_MAX_SPAN  (64 * 1024)
+
+HRESULT
+LLDBServices::ReadVirtualBatch(
+    PREAD_VIRTUAL_REQUEST requests,
+    ULONG count)
+{
+    if (requests == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Sort the requests by address so adjacent and overlapping ranges can be merged
+    // into one lldb read. The per-read overhead of the SB APIs dominates small reads.
+    m_batchOrder.clear();
+    for (ULONG i = 0; i < count; i++)
+    {
+        requests[i].bytesRead = 0;
+        if (requests[i].bufferSize > 0)
+        {
+            m_batchOrder.push_back(i);
+        }
+    }
+    std::sort(m_batchOrder.begin(), m_batchOrder.end(), [requests](ULONG a, ULONG b) {
+        return CONVERT_FROM_SIGN_EXTENDED(requests[a].offset) < CONVERT_FROM_SIGN_EXTENDED(requests[b].offset);
+    });
+
+    size_t first = 0;
+    while (first < m_batchOrder.size())
+    {
+        ULONG64 start = CONVERT_FROM_SIGN_EXTENDED(requests[m_batchOrder[first]].offset);
+        ULONG64 end = start + requests[m_batchOrder[first]].bufferSize;
+        size_t last = first + 1;
+        if (end > start)
+        {
+            while (last < m_batchOrder.size())
+            {
+                const READ_VIRTUAL_REQUEST& request = requests[m_batchOrder[last]];
+                ULONG64 requestStart = CONVERT_FROM_SIGN_EXTENDED(request.offset);
+                ULONG64 requestEnd = requestStart + request.bufferSize;
+                if (requestEnd < requestStart || requestStart - start > BATCH_MAX_SPAN || requestStart > end + BATCH_MERGE_GAP)
+                {
+                    break;
+                }
+                ULONG64 newEnd = std::max(end, requestEnd);
+                if (newEnd - start > BATCH_MAX_SPAN)
+                {
+                    break;
+                }
+                end = newEnd;
+                last++;
+            }
+        }
+
+        ULONG spanRead = 0;
+        if (last - first > 1)
+        {
+            m_batchBuffer.resize((size_t)(end - start));
+            if (FAILED(ReadVirtual(start, m_batchBuffer.data(), (ULONG)(end - start), &spanRead)))
+            {
+                spanRead = 0;
+            }
+        }
+        for (size_t i = first; i < last; i++)
+        {
+            READ_VIRTUAL_REQUEST& request = requests[m_batchOrder[i]];
+            ULONG64 offset = CONVERT_FROM_SIGN_EXTENDED(request.offset) - start;
+            if (last - first > 1 && offset + request.bufferSize <= spanRead)
+            {
+                memcpy(request.buffer, m_batchBuffer.data() + offset, request.bufferSize);
+                request.bytesRead = request.bufferSize;
+            }
+            else
+            {
+                // Not merged or the merged read came up short; read it on its own so partial
+                // reads are returned the same way ReadVirtual would.
+                ULONG bytesRead = 0;
+                if (FAILED(ReadVirtual(request.offset, request.buffer, request.bufferSize, &bytesRead)))
+                {
+                    bytesRead = 0;
+                }
+                request.bytesRead = bytesRead;
+            }
+        }
+        first = last;
+    }
+
+    for (ULONG i = 0; i < count; i++)
+    {
+        if (requests[i].bytesRead < requests[i].bufferSize)
+        {
+            return S_FALSE;
+        }
+    }
+    return S_OK;
+}
+
+// SBProcess::GetCoreFile is only available in newer versions of lldb
+template <typename T>
+static auto
+GetCoreFilePath(T& process, int) -> decltype(process.GetCoreFile(), std::string())
+{
+    lldb::SBFileSpec coreFile = process.GetCoreFile();
+    if (coreFile.IsValid())
+    {
+        char path[4096];
+        if (coreFile.GetPath(path, sizeof(path)) > 0)
+        {
+            return std::string(path);
+        }
+    }
+    return std::string();
+}
+
+template <typename T>
+static std::string
+GetCoreFilePath(T& process, long)
+{
+    return std::string();
+}
+
+ElfCoreFile*
+LLDBServices::GetCoreFile(lldb::SBProcess& process)
+{
+    uint32_t processId = process.GetUniqueID();
+    if (processId != m_coreFileProcessId)
+    {
+        m_coreFileProcessId = processId;
+        m_coreFile.Close();
+
+        const char* pluginName = process.GetPluginName();
+        if (pluginName != nullptr && strcmp(pluginName, "elf-core") == 0)
+        {
+            std::string path = GetCoreFilePath(process, 0);
+            if (!path.empty())
+            {
+                m_coreFile.Open(path.c_str());
+            }
+        }
+    }
+    return m_coreFile.IsOpen() ? &m_coreFile : nullptr;
+}
+
+// The unreadable ranges are only valid while the target is stopped at the same
+// place; a live process can map more memory once it runs.
+void
+LLDBServices::EnsureUnreadableRanges(lldb::SBProcess& process)
+{
+    uint32_t processId = process.GetUniqueID();
+    if (m_unreadableStopId != m_currentStopId || m_unreadableProcessId != processId)
+    {
+        m_unreadableRanges.clear();
+        m_unreadableStopId = m_currentStopId;
+        m_unreadableProcessId = processId;
+    }
+}
+
+// Returns true if any part of [offset, offset + size) is known to be unreadable and
+// the start of the first such part.
+bool
+LLDBServices::FindUnreadableRange(
+    uint64_t offset,
+    uint64_t size,
+    uint64_t& unreadableStart)
+{
+    if (m_unreadableRanges.empty())
+    {
+        return false;
+    }
+    uint64_t end = size > UINT64_MAX - offset ? UINT64_MAX : offset + size;
+
+    // The range starting at or below offset may cover it
+    auto it = m_unreadableRanges.upper_bound(offset);
+    if (it != m_unreadableRanges.begin())
+    {
+        auto prev = std::prev(it);
+        if (prev->second > offset)
+        {
+            unreadableStart = offset;
+            return true;
+        }
+    }
+    // Otherwise the next range may start inside the request
+    if (it != m_unreadableRanges.end() && it->first < end)
+    {
+        unreadableStart = it->first;
+        return true;
+    }
+    return false;
+}
+
+void
+LLDBServices::AddUnreadableRange(
+    lldb::SBTarget& target,
+    uint64_t start,
+    uint64_t end)
+{
+    if (end <= start)
+    {
+        return;
+    }
+    // A smaller read of a page backed by a module section can still succeed, so
+    // never mark those unreadable.
+    EnsureSectionRanges(target);
+    auto section = std::upper_bound(m_sectionRanges.begin(), m_sectionRanges.end(), end,
+        [](uint64_t value, const SectionRange& entry) { return value <= entry.loadAddr; });
+    for (auto it = m_sectionRanges.begin(); it != section; ++it)
+    {
+        if (it->endAddr > start)
+        {
+            return;
+        }
+    }
+
+    // Merge with the ranges it touches or overlaps
+    auto it = m_unreadableRanges.upper_bound(start);
+    if (it != m_unreadableRanges.begin())
+    {
+        auto prev = std::prev(it);
+        if (prev->second >= start)
+        {
+            start = prev->first;
+            end = std::max(end, prev->second);
+            it = m_unreadableRanges.erase(prev);
+        }
+    }
+    while (it != m_unreadableRanges.end() && it->first <= end)
+    {
+        end = std::max(end, it->second);
+        it = m_unreadableRanges.erase(it);
+    }
+    m_unreadableRanges.emplace(start, end);
+}
+
 void
 LLDBServices::EnsureSectionRanges(lldb::SBTarget& target)
 {
@@ -2734,6 +3022,28 @@ LLDBServices::GetDacSignatureVerificationSettings(
     return S_OK;
 }
 
+ULONG
+LLDBServices::GetStopId()
+{
+    return m_currentStopId;
+}
+
+HRESULT
+LLDBServices::GetMemoryReadStatistics(
+    PMEMORY_READ_STATISTICS statistics)
+{
+    if (statistics == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+    statistics->unreadableRanges = (ULONG)m_unreadableRanges.size();
+    statistics->unreadableHits = m_unreadableHits;
+    statistics->readCalls = m_readCalls;
+    statistics->bytesRead = m_bytesRead;
+    statistics->failedReads = m_failedReads;
+    return S_OK;
+}
+
 //----------------------------------------------------------------------------
 // Helper functions
 //----------------------------------------------------------------------------
@@ -3005,111 +3315,92 @@ LLDBServices::GetVersionStringFromSection(lldb::SBTarget& target, lldb::SBSectio
 #define VersionLength 12
 static const char* g_versionString = "@(#)Version ";
 
-bool
-LLDBServices::SearchVersionString(
-    uint64_t address,
-    int32_t size,
-    char* versionBuffer,
-    int versionBufferSize)
-{
-    BYTE buffer[VersionLength];
-    ULONG cbBytesRead;
-    bool result;
-
-    ClearCache();
+// Size of the reads used to scan a data section for the version string
+#define VersionSearchChunkSize (64 * 1024)
 
-    while (size > 0)
+// Returns the first "@(#)Version " marker in the buffer or nullptr. memchr is vectorized
+// by the C runtime so this is much faster than comparing at every byte offset.
+static const BYTE*
+FindVersionString(const BYTE* buffer, size_t size)
+{
+    const BYTE* current = buffer;
+    const BYTE* end = buffer + size;
+    while ((size_t)(end - current) >= VersionLength)
     {
-        result = ReadVirtualCache(address, buffer, VersionLength, &cbBytesRead);
-        if (result && cbBytesRead >= VersionLength)
+        const BYTE* candidate = (const BYTE*)memchr(current, g_versionString[0], (end - current) - (VersionLength - 1));
+        if (candidate == nullptr)
         {
-            if (memcmp(buffer, g_versionString, VersionLength) == 0)
-            {
-                for (int i = 0; i < versionBufferSize; i++)
-                {
-                    // Now read the version string a char/byte at a time
-                    result = ReadVirtualCache(address, &versionBuffer[i], 1, &cbBytesRead);
-
-                    // Return not found if there are any failures or problems while reading the version string.
-                    if (!result || cbBytesRead < 1 || size <= 0) {
-                        break;
-                    }
-                    // Found the end of the string
-                    if (versionBuffer[i] == '\0') {
-                        return true;
-                    }
-                    address++;
-                    size--;
-                }
-                // Return not found if overflowed the versionBuffer (not finding a null).
-                break;
-            }
-            address++;
-            size--;
+            break;
         }
-        else
+        if (memcmp(candidate, g_versionString, VersionLength) == 0)
         {
-            address += VersionLength;
-            size -= VersionLength;
+            return candidate;
         }
+        current = candidate + 1;
     }
-
-    return false;
+    return nullptr;
 }
 
 bool
-LLDBServices::ReadVirtualCache(ULONG64 address, PVOID buffer, ULONG bufferSize, PULONG pcbBytesRead)
+LLDBServices::SearchVersionString(
+    uint64_t address,
+    int32_t size,
+    char* versionBuffer,
+    int versionBufferSize)
 {
-    if (bufferSize == 0)
+    if (size <= 0 || versionBufferSize <= 0)
     {
-        return true;
+        return false;
     }
+    uint64_t end = (uint64_t)size > UINT64_MAX - address ? UINT64_MAX : address + size;
 
-    if (bufferSize > CACHE_SIZE)
-    {
-        // Don't even try with the cache
-        return ReadVirtual(address, buffer, bufferSize, pcbBytesRead) == S_OK;
-    }
+    // The section is read in large chunks. The last VersionLength - 1 bytes of each chunk
+    // are carried over to the start of the buffer so markers spanning chunks are found.
+    std::vector<BYTE> buffer(VersionSearchChunkSize);
+    uint64_t bufferStart = address;
+    size_t carry = 0;
 
-    if (!m_cacheValid || (address < m_startCache) || (address > (m_startCache + m_cacheSize - bufferSize)))
+    while (address < end)
     {
-        ULONG cbBytesRead = 0;
-
-        m_cacheValid = false;
-        m_startCache = address;
-
-        // Avoid an int overflow
-        if (m_startCache + CACHE_SIZE < m_startCache)
-            m_startCache = (ULONG64)(-CACHE_SIZE);
-
-        HRESULT hr = ReadVirtual(m_startCache, m_cache, CACHE_SIZE, &cbBytesRead);
-        if (hr != S_OK)
+        ULONG bytesRead = 0;
+        ULONG readSize = (ULONG)std::min<uint64_t>(VersionSearchChunkSize - carry, end - address);
+        if (FAILED(ReadVirtual(address, buffer.data() + carry, readSize, &bytesRead)) || bytesRead == 0)
         {
-            return false;
+            // Skip the unreadable page; nothing carried over can match across it
+            uint64_t nextPage = (address + PAGE_SIZE) & PAGE_MASK;
+            if (nextPage <= address)
+            {
+                break;
+            }
+            address = nextPage;
+            bufferStart = address;
+            carry = 0;
+            continue;
+        }
+
+        size_t available = carry + bytesRead;
+        const BYTE* match = FindVersionString(buffer.data(), available);
+        if (match != nullptr)
+        {
+            // Read the whole version string (including the marker) at once. Return not
+            // found if it can't be read or doesn't end (null) within the versionBuffer.
+            uint64_t versionAddress = bufferStart + (match - buffer.data());
+            ULONG versionSize = (ULONG)std::min<uint64_t>(versionBufferSize, end - versionAddress);
+            ULONG versionRead = 0;
+            if (FAILED(ReadVirtual(versionAddress, versionBuffer, versionSize, &versionRead)))
+            {
+                return false;
+            }
+            return memchr(versionBuffer, '\0', versionRead) != nullptr;
         }
 
-        m_cacheSize = cbBytesRead;
-        m_cacheValid = true;
-    }
-
-    // If the address is within the cache, copy the cached memory to the input buffer
-    LONG_PTR cacheOffset = address - m_startCache;
-    if (cacheOffset >= 0 && cacheOffset < CACHE_SIZE)
-    {
-        int size = std::min(bufferSize, m_cacheSize);
-        memcpy(buffer, (LPVOID)(m_cache + cacheOffset), size);
-
-        if (pcbBytesRead != NULL)
-        {
-            *pcbBytesRead = size;
-        }
-    }
-    else
-    {
-        return false;
+        address += bytesRead;
+        carry = std::min<size_t>(available, VersionLength - 1);
+        memmove(buffer.data(), buffer.data() + available - carry, carry);
+        bufferStart = address - carry;
     }
 
-    return true;
+    return false;
 }
 
 lldb::SBCommand
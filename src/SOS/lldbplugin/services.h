@@ -3,10 +3,10 @@
 
 #include <cstdarg>
 #include <string>
+#include <map>
 #include <set>
 #include <vector>
-
-#define CACHE_SIZE  4096
+#include "elfcorefile.h"
 
 // Cached module section range used by ReadVirtual to satisfy reads not
 // backed by the lldb process (e.g., code/text segments missing from a
@@ -34,14 +34,24 @@ private:
 
     lldb::SBCommandReturnObject *m_currentResult;
 
-    BYTE m_cache[CACHE_SIZE];
-    ULONG64 m_startCache;
-    bool m_cacheValid;
-    ULONG m_cacheSize;
-
     std::vector<SectionRange> m_sectionRanges;
     uint32_t m_sectionCacheStopId;
 
+    ElfCoreFile m_coreFile;
+    uint32_t m_coreFileProcessId;
+
+    std::map<uint64_t, uint64_t> m_unreadableRanges;
+    uint32_t m_unreadableStopId;
+    uint32_t m_unreadableProcessId;
+    uint64_t m_unreadableHits;
+
+    uint64_t m_readCalls;
+    uint64_t m_bytesRead;
+    uint64_t m_failedReads;
+
+    std::vector<ULONG> m_batchOrder;
+    std::vector<BYTE> m_batchBuffer;
+
     ULONG64 GetModuleBase(lldb::SBTarget& target, lldb::SBModule& module);
     ULONG64 GetModuleSize(lldb::SBTarget& target, ULONG64 baseAddress, lldb::SBModule& module);
     ULONG64 GetExpression(lldb::SBFrame& frame, lldb::SBError& error, PCSTR exp);
@@ -50,16 +60,14 @@ private:
 
     bool GetVersionStringFromSection(lldb::SBTarget& target, lldb::SBSection& section, char* versionBuffer);
     bool SearchVersionString(uint64_t address, int32_t size, char* versionBuffer, int versionBufferSize);
-    bool ReadVirtualCache(ULONG64 address, PVOID buffer, ULONG bufferSize, PULONG pcbBytesRead);
 
     void EnsureSectionRanges(lldb::SBTarget& target);
     bool ReadFromSectionCache(lldb::SBTarget& target, uint64_t offset, uint32_t size, void* buffer, lldb::SBError& error, size_t& bytesRead);
+    ElfCoreFile* GetCoreFile(lldb::SBProcess& process);
 
-    void ClearCache()
-    {
-        m_cacheValid = false;
-        m_cacheSize = CACHE_SIZE;
-    }
+    void EnsureUnreadableRanges(lldb::SBProcess& process);
+    bool FindUnreadableRange(uint64_t offset, uint64_t size, uint64_t& unreadableStart);
+    void AddUnreadableRange(lldb::SBTarget& target, uint64_t start, uint64_t end);
 
     void LoadNativeSymbols(lldb::SBTarget target, lldb::SBModule module, PFN_MODULE_LOAD_CALLBACK callback);
 
@@ -443,6 +451,15 @@ public:
     HRESULT STDMETHODCALLTYPE GetDacSignatureVerificationSettings(
         BOOL* dacSignatureVerificationEnabled);
 
+    ULONG STDMETHODCALLTYPE GetStopId();
+
+    HRESULT STDMETHODCALLTYPE GetMemoryReadStatistics(
+        PMEMORY_READ_STATISTICS statistics);
+
+    HRESULT STDMETHODCALLTYPE ReadVirtualBatch(
+        PREAD_VIRTUAL_REQUEST requests,
+        ULONG count);
+
     //----------------------------------------------------------------------------
     // LLDBServices (internal)
     //----------------------------------------------------------------------------
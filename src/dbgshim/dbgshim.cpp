@@ -1312,9 +1312,12 @@ GetTargetCLRMetrics(
         else
         { 
             RuntimeInfo runtimeInfo;
-            if (!TryReadSymbolFromFile(wszModulePath, RUNTIME_INFO_SIGNATURE, (BYTE*)&runtimeInfo, sizeof(RuntimeInfo)))
+            bool notFound;
+            if (!TryReadSymbolFromFile(wszModulePath, RUNTIME_INFO_SIGNATURE, (BYTE*)&runtimeInfo, sizeof(RuntimeInfo), &notFound))
             {
-                return E_FAIL;
+                // E_FAIL means the module was read and isn't a single-file app. The file may not have been
+                // readable at the moment (or isn't a module); return a different error so that isn't cached.
+                return notFound ? E_FAIL : HRESULT_FROM_WIN32(ERROR_READ_FAULT);
             }
             if (strcmp(runtimeInfo.Signature, RUNTIME_INFO_SIGNATURE) != 0)
             {
@@ -1401,6 +1404,208 @@ EnumProcessModulesInternal(
     return S_OK;
 }
 
+//
+// The GetTargetCLRMetrics results of the module files probed by GetRuntime. The entries are keyed on the
+// module path plus the file's size, creation (inode change on Unix) and last write times so a replaced
+// file is probed again. Repeated attaches, and the retry loop waiting for a runtime to start, then skip
+// parsing the modules already looked at. Only "is a runtime" (S_OK with valid index info) and "is not a
+// runtime" (E_FAIL, only returned when the file was read and parsed) results are kept; anything else may
+// be transient and is probed again next time. The list is bounded and, like its lock, never freed: startup
+// helper threads may still be probing modules while the process exits.
+//
+struct RuntimeProbeCacheEntry
+{
+    RuntimeProbeCacheEntry* Next;
+    WCHAR* ModulePath;
+    WIN32_FILE_ATTRIBUTE_DATA FileData;
+    HRESULT Result;
+    CLR_ENGINE_METRICS EngineMetrics;
+    ClrInfo ClrInfo;
+    DWORD RVAContinueStartupEvent;
+};
+
+#define RUNTIME_PROBE_CACHE_MAX_ENTRIES 4096
+
+static RuntimeProbeCacheEntry* g_runtimeProbeCache = nullptr;
+static DWORD g_runtimeProbeCacheCount = 0;
+static CRITICAL_SECTION* g_runtimeProbeCacheLock = nullptr;
+
+static
+void
+DeleteRuntimeProbeCacheEntry(
+    RuntimeProbeCacheEntry* entry)
+{
+    delete [] entry->ModulePath;
+    delete entry;
+}
+
+static
+CRITICAL_SECTION*
+GetRuntimeProbeCacheLock()
+{
+    CRITICAL_SECTION* lock = VolatileLoad(&g_runtimeProbeCacheLock);
+    if (lock == nullptr)
+    {
+        CRITICAL_SECTION* newLock = new (nothrow) CRITICAL_SECTION;
+        if (newLock == nullptr)
+        {
+            return nullptr;
+        }
+        InitializeCriticalSection(newLock);
+        lock = InterlockedCompareExchangeT(&g_runtimeProbeCacheLock, newLock, nullptr);
+        if (lock != nullptr)
+        {
+            // Another thread created the lock first
+            DeleteCriticalSection(newLock);
+            delete newLock;
+        }
+        else
+        {
+            lock = newLock;
+        }
+    }
+    return lock;
+}
+
+static
+bool
+IsSameModulePath(
+    LPCWSTR modulePath1,
+    LPCWSTR modulePath2)
+{
+#ifdef TARGET_WINDOWS
+    return _wcsicmp(modulePath1, modulePath2) == 0;
+#else
+    return u16_strcmp(modulePath1, modulePath2) == 0;
+#endif
+}
+
+static
+bool
+IsSameModuleFile(
+    const WIN32_FILE_ATTRIBUTE_DATA& fileData1,
+    const WIN32_FILE_ATTRIBUTE_DATA& fileData2)
+{
+    return fileData1.nFileSizeHigh == fileData2.nFileSizeHigh &&
+        fileData1.nFileSizeLow == fileData2.nFileSizeLow &&
+        fileData1.ftLastWriteTime.dwHighDateTime == fileData2.ftLastWriteTime.dwHighDateTime &&
+        fileData1.ftLastWriteTime.dwLowDateTime == fileData2.ftLastWriteTime.dwLowDateTime &&
+        fileData1.ftCreationTime.dwHighDateTime == fileData2.ftCreationTime.dwHighDateTime &&
+        fileData1.ftCreationTime.dwLowDateTime == fileData2.ftCreationTime.dwLowDateTime;
+}
+
+//
+// GetTargetCLRMetrics with the results cached per module file. The out parameters are only written on success.
+//
+static
+HRESULT
+GetCachedTargetCLRMetrics(
+    LPCWSTR wszModulePath,
+    CLR_ENGINE_METRICS *pEngineMetricsOut,
+    ClrInfo* pClrInfoOut,
+    DWORD *pdwRVAContinueStartupEvent)
+{
+    _ASSERTE(pEngineMetricsOut != NULL);
+    _ASSERTE(pClrInfoOut != NULL);
+    _ASSERTE(pdwRVAContinueStartupEvent != NULL);
+
+    WIN32_FILE_ATTRIBUTE_DATA fileData;
+    CRITICAL_SECTION* lock = GetRuntimeProbeCacheLock();
+    if (lock == nullptr || !GetFileAttributesExW(wszModulePath, GetFileExInfoStandard, &fileData))
+    {
+        return GetTargetCLRMetrics(wszModulePath, pEngineMetricsOut, pClrInfoOut, pdwRVAContinueStartupEvent);
+    }
+
+    EnterCriticalSection(lock);
+    for (RuntimeProbeCacheEntry* entry = g_runtimeProbeCache; entry != nullptr; entry = entry->Next)
+    {
+        if (IsSameModulePath(entry->ModulePath, wszModulePath))
+        {
+            if (IsSameModuleFile(entry->FileData, fileData))
+            {
+                HRESULT hr = entry->Result;
+                if (SUCCEEDED(hr))
+                {
+                    *pEngineMetricsOut = entry->EngineMetrics;
+                    pClrInfoOut->CopyIndexes(entry->ClrInfo);
+                    *pdwRVAContinueStartupEvent = entry->RVAContinueStartupEvent;
+                }
+                LeaveCriticalSection(lock);
+                return hr;
+            }
+            break;
+        }
+    }
+    LeaveCriticalSection(lock);
+
+    // Probe the module file without holding the lock
+    CLR_ENGINE_METRICS engineMetrics = *pEngineMetricsOut;
+    ClrInfo clrInfo;
+    DWORD rvaContinueStartupEvent = 0;
+    HRESULT hr = GetTargetCLRMetrics(wszModulePath, &engineMetrics, &clrInfo, &rvaContinueStartupEvent);
+    if (SUCCEEDED(hr))
+    {
+        *pEngineMetricsOut = engineMetrics;
+        pClrInfoOut->CopyIndexes(clrInfo);
+        *pdwRVAContinueStartupEvent = rvaContinueStartupEvent;
+    }
+    if (!((hr == S_OK && clrInfo.IsValid()) || hr == E_FAIL))
+    {
+        return hr;
+    }
+
+    EnterCriticalSection(lock);
+    RuntimeProbeCacheEntry* entry = g_runtimeProbeCache;
+    for (; entry != nullptr; entry = entry->Next)
+    {
+        if (IsSameModulePath(entry->ModulePath, wszModulePath))
+        {
+            break;
+        }
+    }
+    if (entry == nullptr)
+    {
+        if (g_runtimeProbeCacheCount >= RUNTIME_PROBE_CACHE_MAX_ENTRIES)
+        {
+            // Drop the oldest entry (the last one) to make room
+            RuntimeProbeCacheEntry** last = &g_runtimeProbeCache;
+            while ((*last)->Next != nullptr)
+            {
+                last = &(*last)->Next;
+            }
+            DeleteRuntimeProbeCacheEntry(*last);
+            *last = nullptr;
+            g_runtimeProbeCacheCount--;
+        }
+        size_t length = u16_strlen(wszModulePath) + 1;
+        WCHAR* modulePath = new (nothrow) WCHAR[length];
+        entry = modulePath != nullptr ? new (nothrow) RuntimeProbeCacheEntry : nullptr;
+        if (entry != nullptr)
+        {
+            memcpy(modulePath, wszModulePath, length * sizeof(WCHAR));
+            entry->ModulePath = modulePath;
+            entry->Next = g_runtimeProbeCache;
+            g_runtimeProbeCache = entry;
+            g_runtimeProbeCacheCount++;
+        }
+        else
+        {
+            delete [] modulePath;
+        }
+    }
+    if (entry != nullptr)
+    {
+        // Add the new or replace the stale results
+        entry->FileData = fileData;
+        entry->Result = hr;
+        entry->EngineMetrics = engineMetrics;
+        entry->ClrInfo.CopyIndexes(clrInfo);
+        entry->RVAContinueStartupEvent = rvaContinueStartupEvent;
+    }
+    LeaveCriticalSection(lock);
+    return hr;
+}
+
 //
 // Finds any coreclr or single-file app in the process
 //
@@ -1426,7 +1631,8 @@ GetRuntime(
     }
 
     // This assumes we are only going to find one .NET runtime in the process. We do the module 
-    // enumeration only once because looking for single-file runtime info symbol is expensive.
+    // enumeration only once because looking for single-file runtime info symbol is expensive. The
+    // results for each module file are cached so the modules are only parsed on the first probe.
 
     WCHAR modulePath[MAX_LONGPATH];
     for (DWORD i = 0; i < countModules; i++)
@@ -1444,7 +1650,7 @@ GetRuntime(
         // Get the DBI/DAC index info for the regular coreclr module or check if single-file app by looking for the 
         // DotNetRuntimeInfo export. We need to get the metrics too because that is required to get the startup event.
         DWORD rvaContinueStartupEvent = 0;
-        hr = GetTargetCLRMetrics(modulePath, &clrRuntimeInfo.EngineMetrics, &clrRuntimeInfo.ClrInfo, &rvaContinueStartupEvent);
+        hr = GetCachedTargetCLRMetrics(modulePath, &clrRuntimeInfo.EngineMetrics, &clrRuntimeInfo.ClrInfo, &rvaContinueStartupEvent);
         if (SUCCEEDED(hr))
         {
             clrRuntimeInfo.ModuleHandle = modules[i];
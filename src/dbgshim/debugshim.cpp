@@ -688,11 +688,19 @@ HRESULT CLRDebuggingImpl::GetCLRInfo(ICorDebugDataTarget * pDataTarget,
     {
         clrInfo.WindowsTarget = FALSE;
 
+        // Parse the module's headers and export tables once for both the symbol and the build id lookups
+        void* symbolIndex = CreateSymbolIndex(pDataTarget, moduleBaseAddress);
+        if (symbolIndex == nullptr)
+        {
+            return E_OUTOFMEMORY;
+        }
+
         //
         // Check if it is a single-file app
         //
+        const char* symbolName = RUNTIME_INFO_SIGNATURE;
         uint64_t symbolAddress;
-        if (TryGetSymbol(pDataTarget, moduleBaseAddress, RUNTIME_INFO_SIGNATURE, &symbolAddress))
+        if (TryGetSymbolsFromIndex(symbolIndex, 1, &symbolName, &symbolAddress) == 1)
         {
             RuntimeInfo runtimeInfo;
             ULONG32 bytesRead;
@@ -718,13 +726,14 @@ HRESULT CLRDebuggingImpl::GetCLRInfo(ICorDebugDataTarget * pDataTarget,
         //
         if (!clrInfo.IsValid())
         {
-            if (TryGetBuildId(pDataTarget, moduleBaseAddress, clrInfo.RuntimeBuildId, MAX_BUILDID_SIZE, &clrInfo.RuntimeBuildIdSize)) 
+            if (TryGetBuildIdFromIndex(symbolIndex, clrInfo.RuntimeBuildId, MAX_BUILDID_SIZE, &clrInfo.RuntimeBuildIdSize)) 
             {
                 // This is normal non-single-file app
                 clrInfo.IndexType = LIBRARY_PROVIDER_INDEX_TYPE::Runtime; 
             }
         }
 
+        DestroySymbolIndex(symbolIndex);
         return S_OK;
     }
 }
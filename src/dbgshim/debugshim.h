@@ -107,6 +107,28 @@ struct ClrInfo
         swprintf_s(DacName, MAX_PATH_FNAME, W("%s"), MAKEDLLNAME_W(CORECLR_DAC_MODULE_NAME_W));
     }
 
+    // Copies all the fields but RuntimeModulePath (the index info of the runtime, DBI and DAC)
+    void CopyIndexes(const ClrInfo& source)
+    {
+        WindowsTarget = source.WindowsTarget;
+        IndexType = source.IndexType;
+
+        memcpy(RuntimeBuildId, source.RuntimeBuildId, sizeof(RuntimeBuildId));
+        RuntimeBuildIdSize = source.RuntimeBuildIdSize;
+
+        DbiTimeStamp = source.DbiTimeStamp;
+        DbiSizeOfImage = source.DbiSizeOfImage;
+        memcpy(DbiBuildId, source.DbiBuildId, sizeof(DbiBuildId));
+        DbiBuildIdSize = source.DbiBuildIdSize;
+        memcpy(DbiName, source.DbiName, sizeof(DbiName));
+
+        DacTimeStamp = source.DacTimeStamp;
+        DacSizeOfImage = source.DacSizeOfImage;
+        memcpy(DacBuildId, source.DacBuildId, sizeof(DacBuildId));
+        DacBuildIdSize = source.DacBuildIdSize;
+        memcpy(DacName, source.DacName, sizeof(DacName));
+    }
+
     bool IsValid()
     {
         if (IndexType == LIBRARY_PROVIDER_INDEX_TYPE::Identity)
@@ -134,8 +156,12 @@ struct ClrInfo
 
 extern "C" bool TryGetSymbol(ICorDebugDataTarget* dataTarget, uint64_t baseAddress, const char* symbolName, uint64_t* symbolAddress);
 extern "C" bool TryGetBuildId(ICorDebugDataTarget* dataTarget, uint64_t baseAddress, BYTE* buffer, ULONG bufferSize, PULONG pBuildIdSize);
+extern "C" void* CreateSymbolIndex(ICorDebugDataTarget* dataTarget, uint64_t baseAddress);
+extern "C" int TryGetSymbolsFromIndex(void* symbolIndex, int count, const char* const* symbolNames, uint64_t* symbolAddresses);
+extern "C" bool TryGetBuildIdFromIndex(void* symbolIndex, BYTE* buffer, ULONG bufferSize, PULONG pBuildIdSize);
+extern "C" void DestroySymbolIndex(void* symbolIndex);
 #ifdef TARGET_UNIX
-extern "C" bool TryReadSymbolFromFile(const WCHAR* modulePath, const char* symbolName, BYTE* buffer, ULONG32 size);
+extern "C" bool TryReadSymbolFromFile(const WCHAR* modulePath, const char* symbolName, BYTE* buffer, ULONG32 size, bool* pNotFound);
 extern "C" bool TryGetBuildIdFromFile(const WCHAR* modulePath, BYTE* buffer, ULONG bufferSize, PULONG pBuildSize);
 #endif
 
@@ -7,8 +7,14 @@
 #include <cordebug.h>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <algorithm>
 #include "elfreader.h"
+#include "memorychunks.h"
 #include "arrayholder.h"
+#ifdef HOST_UNIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #define Elf_Ehdr   ElfW(Ehdr)
 #define Elf_Phdr   ElfW(Phdr)
@@ -31,6 +37,10 @@
 #define PRIxA PRIA PRIx
 #endif
 
+// The dynamic section, link_map name and node reads are split at 4K boundaries, the smallest
+// page size, so a read never crosses into a page that isn't mapped or in the core dump.
+#define ELF_READ_CHUNK_SIZE 0x1000
+
 #ifndef HOST_WINDOWS
 static const char ElfMagic[] = { 0x7f, 'E', 'L', 'F', '\0' };
 #endif
@@ -47,16 +57,25 @@ private:
         uint64_t FileOffset;
     };
     FILE* m_file;
+    uint8_t* m_base;
+    size_t m_size;
     std::vector<ProgramHeader> m_programHeaders;
 
 public:
     ElfReaderFromFile() : ElfReader(true),
-        m_file(NULL)
+        m_file(NULL),
+        m_base(NULL),
+        m_size(0)
     {
     }
 
     virtual ~ElfReaderFromFile()
     {
+        if (m_base != NULL)
+        {
+            munmap(m_base, m_size);
+            m_base = NULL;
+        }
         if (m_file != NULL)
         {
             fclose(m_file);
@@ -68,7 +87,30 @@ public:
     {
         _ASSERTE(m_file == NULL);
         m_file = _wfopen(modulePath, W("rb"));
-        return m_file != NULL;
+        if (m_file == NULL)
+        {
+            return false;
+        }
+        // Map the whole file so the header, symbol and string table reads are just copies. If
+        // the file can't be mapped (i.e. a single-file bundle bigger than the address space)
+        // fall back to seeking and reading the file.
+        struct stat st;
+        if (fstat(fileno(m_file), &st) == 0 && st.st_size > 0 && (uint64_t)st.st_size <= SIZE_MAX)
+        {
+            void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fileno(m_file), 0);
+            if (base != MAP_FAILED)
+            {
+                m_base = (uint8_t*)base;
+                m_size = (size_t)st.st_size;
+
+                // The reads hop between the headers and tables; don't let the kernel read ahead
+                // large chunks of a big bundle.
+                madvise(m_base, m_size, MADV_RANDOM);
+                fclose(m_file);
+                m_file = NULL;
+            }
+        }
+        return true;
     }
 
     uint64_t GetFileOffset(uint64_t address)
@@ -99,11 +141,21 @@ public:
 
     virtual bool ReadMemory(const void* address, void* buffer, size_t size)
     {
+        if (m_base != NULL)
+        {
+            size_t offset = (size_t)address;
+            if (offset >= m_size || size > (m_size - offset))
+            {
+                return false;
+            }
+            memcpy(buffer, m_base + offset, size);
+            return true;
+        }
         if (m_file == NULL)
         {
             return false;
         }
-        if (fseek(m_file, (LONG_PTR)address, SEEK_SET) != 0)
+        if (fseeko(m_file, (off_t)address, SEEK_SET) != 0)
         {
             return false;
         }
@@ -113,11 +165,16 @@ public:
 };
 
 //
-// Entry point to get an export symbol from a module file
+// Entry point to get an export symbol from a module file. If pNotFound isn't null it is set to
+// true only when the file was read and parsed but doesn't export the symbol.
 //
 extern "C" bool
-TryReadSymbolFromFile(const WCHAR* modulePath, const char* symbolName, BYTE* buffer, ULONG32 size)
+TryReadSymbolFromFile(const WCHAR* modulePath, const char* symbolName, BYTE* buffer, ULONG32 size, bool* pNotFound)
 {
+    if (pNotFound != nullptr)
+    {
+        *pNotFound = false;
+    }
     ElfReaderFromFile reader;
     if (reader.OpenFile(modulePath))
     {
@@ -132,6 +189,10 @@ TryReadSymbolFromFile(const WCHAR* modulePath, const char* symbolName, BYTE* buf
                     return reader.ReadMemory((void*)symbolOffset, buffer, size);
                 }
             }
+            else if (pNotFound != nullptr)
+            {
+                *pNotFound = true;
+            }
         }
     }
     return false;
@@ -207,6 +268,20 @@ TryGetSymbolWithCallback(ReadMemoryCallback readMemory, uint64_t baseAddress, co
     return false;
 }
 
+//
+// Get the build id of the module with a memory read callback
+//
+extern "C" bool
+TryGetBuildIdWithCallback(ReadMemoryCallback readMemory, uint64_t baseAddress, BYTE* buffer, ULONG bufferSize, PULONG pBuildSize)
+{
+    ElfReaderWithCallback reader(readMemory);
+    if (reader.EnumerateProgramHeaders(baseAddress, nullptr, nullptr))
+    {
+        return reader.GetBuildId(buffer, bufferSize, pBuildSize);
+    }
+    return false;
+}
+
 class ElfReaderExport : public ElfReader
 {
 private:
@@ -267,6 +342,112 @@ TryGetBuildId(ICorDebugDataTarget* dataTarget, uint64_t baseAddress, BYTE* buffe
     return false;
 }
 
+//
+// Parsed export symbol tables of a module that can be reused to resolve any number of names
+// (and the build id) without re-reading the program headers, dynamic section and hash table
+// for each lookup.
+//
+class ElfSymbolIndex
+{
+private:
+    ElfReader* m_reader;
+    uint64_t m_baseAddress;
+    bool m_symbolsValid;
+
+public:
+    ElfSymbolIndex(ElfReader* reader, uint64_t baseAddress) :
+        m_reader(reader),
+        m_baseAddress(baseAddress)
+    {
+        m_symbolsValid = reader->PopulateForSymbolLookup(baseAddress);
+    }
+
+    ~ElfSymbolIndex()
+    {
+        delete m_reader;
+    }
+
+    int TryGetSymbols(int count, const char* const* symbolNames, uint64_t* symbolAddresses)
+    {
+        int found = 0;
+        for (int i = 0; i < count; i++)
+        {
+            uint64_t symbolOffset;
+            if (m_symbolsValid && m_reader->TryLookupSymbol(symbolNames[i], &symbolOffset))
+            {
+                symbolAddresses[i] = m_baseAddress + symbolOffset;
+                found++;
+            }
+            else
+            {
+                symbolAddresses[i] = 0;
+            }
+        }
+        return found;
+    }
+
+    bool GetBuildId(BYTE* buffer, ULONG bufferSize, PULONG pBuildSize)
+    {
+        return m_reader->GetBuildId(buffer, bufferSize, pBuildSize);
+    }
+};
+
+static void*
+NewSymbolIndex(ElfReader* reader, uint64_t baseAddress)
+{
+    if (reader == nullptr)
+    {
+        return nullptr;
+    }
+    ElfSymbolIndex* symbolIndex = new (std::nothrow) ElfSymbolIndex(reader, baseAddress);
+    if (symbolIndex == nullptr)
+    {
+        delete reader;
+    }
+    return symbolIndex;
+}
+
+//
+// Entry points to create a symbol index for the module at the base address. Returns nullptr
+// only if out of memory; lookups on an index of a module that can't be parsed just fail.
+//
+extern "C" void*
+CreateSymbolIndexWithCallback(ReadMemoryCallback readMemory, uint64_t baseAddress)
+{
+    return NewSymbolIndex(new (std::nothrow) ElfReaderWithCallback(readMemory), baseAddress);
+}
+
+extern "C" void*
+CreateSymbolIndex(ICorDebugDataTarget* dataTarget, uint64_t baseAddress)
+{
+    return NewSymbolIndex(new (std::nothrow) ElfReaderExport(dataTarget), baseAddress);
+}
+
+//
+// Resolves a batch of export symbols from a symbol index. The addresses of the symbols that
+// aren't found are set to 0. Returns the number of symbols found.
+//
+extern "C" int
+TryGetSymbolsFromIndex(void* symbolIndex, int count, const char* const* symbolNames, uint64_t* symbolAddresses)
+{
+    return ((ElfSymbolIndex*)symbolIndex)->TryGetSymbols(count, symbolNames, symbolAddresses);
+}
+
+//
+// Get the build id of the module from a symbol index
+//
+extern "C" bool
+TryGetBuildIdFromIndex(void* symbolIndex, BYTE* buffer, ULONG bufferSize, PULONG pBuildSize)
+{
+    return ((ElfSymbolIndex*)symbolIndex)->GetBuildId(buffer, bufferSize, pBuildSize);
+}
+
+extern "C" void
+DestroySymbolIndex(void* symbolIndex)
+{
+    delete (ElfSymbolIndex*)symbolIndex;
+}
+
 //
 // ELF reader constructor/destructor
 //
@@ -277,6 +458,7 @@ ElfReader::ElfReader(bool isFileLayout) :
     m_stringTableAddr(nullptr),
     m_stringTableSize(0),
     m_symbolTableAddr(nullptr),
+    m_bloomFilter(nullptr),
     m_buckets(nullptr),
     m_chainsAddress(nullptr),
     m_noteStart(0),
@@ -287,6 +469,9 @@ ElfReader::ElfReader(bool isFileLayout) :
 
 ElfReader::~ElfReader()
 {
+    if (m_bloomFilter != nullptr) {
+        free(m_bloomFilter);
+    }
     if (m_buckets != nullptr) {
         free(m_buckets);
     }
@@ -326,18 +511,13 @@ ElfReader::PopulateForSymbolLookup(uint64_t baseAddress)
     }
 
     // Search for dynamic entries
-    for (;;)
+    std::vector<Elf_Dyn> entries;
+    if (!ReadDynamicEntries(dynamicAddr, entries)) {
+        return false;
+    }
+    for (const Elf_Dyn& dyn : entries)
     {
-        Elf_Dyn dyn;
-        if (!ReadMemory(dynamicAddr, &dyn, sizeof(dyn))) {
-            Trace("ERROR: ReadMemory(%p, %" PRIx ") dyn FAILED\n", dynamicAddr, sizeof(dyn));
-            return false;
-        }
-        Trace("DSO: dyn %p tag %" PRId " (%" PRIx ") d_ptr %" PRIxA "\n", dynamicAddr, dyn.d_tag, dyn.d_tag, dyn.d_un.d_ptr);
-        if (dyn.d_tag == DT_NULL) {
-            break;
-        }
-        else if (dyn.d_tag == DT_GNU_HASH) {
+        if (dyn.d_tag == DT_GNU_HASH) {
             m_gnuHashTableAddr = (void*)(dyn.d_un.d_ptr + loadbias);
         }
         else if (dyn.d_tag == DT_STRTAB) {
@@ -349,7 +529,6 @@ ElfReader::PopulateForSymbolLookup(uint64_t baseAddress)
         else if (dyn.d_tag == DT_SYMTAB) {
             m_symbolTableAddr = (void*)(dyn.d_un.d_ptr + loadbias);
         }
-        dynamicAddr++;
     }
 
     if (m_gnuHashTableAddr == nullptr || m_stringTableAddr == nullptr || m_symbolTableAddr == nullptr) {
@@ -365,6 +544,37 @@ ElfReader::PopulateForSymbolLookup(uint64_t baseAddress)
     return true;
 }
 
+//
+// Reads the dynamic section entries up to and including DT_NULL
+//
+bool
+ElfReader::ReadDynamicEntries(Elf_Dyn* dynamicAddr, std::vector<Elf_Dyn>& entries)
+{
+    // Read the entries up to the end of the page in one request
+    BYTE chunk[ELF_READ_CHUNK_SIZE];
+    bool result = ReadMemoryChunks((uint64_t)dynamicAddr, chunk, sizeof(chunk), sizeof(Elf_Dyn),
+        [this](uint64_t address, BYTE* buffer, size_t size) { return ReadMemory((const void*)address, buffer, size); },
+        [&](const BYTE* data, size_t size)
+        {
+            for (size_t offset = 0; offset < size; offset += sizeof(Elf_Dyn), dynamicAddr++)
+            {
+                Elf_Dyn dyn;
+                memcpy(&dyn, data + offset, sizeof(dyn));
+                Trace("DSO: dyn %p tag %" PRId " (%" PRIx ") d_ptr %" PRIxA "\n", dynamicAddr, dyn.d_tag, dyn.d_tag, dyn.d_un.d_ptr);
+                entries.push_back(dyn);
+                if (dyn.d_tag == DT_NULL) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    if (!result) {
+        Trace("ERROR: ReadMemory(%p, %" PRIx ") dyn FAILED\n", dynamicAddr, sizeof(Elf_Dyn));
+        return false;
+    }
+    return true;
+}
+
 //
 // Symbol table support
 //
@@ -379,15 +589,11 @@ ElfReader::TryLookupSymbol(std::string symbolName, uint64_t* symbolOffset)
         {
             if (GetSymbol(possibleLocation, &symbol))
             {
-                std::string possibleName;
-                if (GetStringAtIndex(symbol.st_name, possibleName))
+                if (IsStringAtIndex(symbol.st_name, symbolName))
                 {
-                    if (symbolName.compare(possibleName) == 0)
-                    {
-                        *symbolOffset = symbol.st_value;
-                        Trace("TryLookupSymbol found '%s' at offset %" PRIxA " in %d\n", symbolName.c_str(), *symbolOffset, symbol.st_shndx);
-                        return true;
-                    }
+                    *symbolOffset = symbol.st_value;
+                    Trace("TryLookupSymbol found '%s' at offset %" PRIxA " in %d\n", symbolName.c_str(), *symbolOffset, symbol.st_shndx);
+                    return true;
                 }
             }
         }
@@ -422,11 +628,22 @@ ElfReader::InitializeGnuHashTable()
         Trace("ERROR: InitializeGnuHashTable invalid BucketCount or SymbolOffset\n");
         return false;
     }
+    // The bloom filter is only an optimization; lookups just walk the chains without it
+    void* bloomAddress = (char*)m_gnuHashTableAddr + sizeof(GnuHashTable);
+    if (m_hashTable.BloomSize > 0)
+    {
+        m_bloomFilter = (size_t*)malloc(m_hashTable.BloomSize * sizeof(size_t));
+        if (m_bloomFilter != nullptr && !ReadMemory(bloomAddress, m_bloomFilter, m_hashTable.BloomSize * sizeof(size_t))) {
+            Trace("InitializeGnuHashTable bloom filter ReadMemory(%p) FAILED\n", bloomAddress);
+            free(m_bloomFilter);
+            m_bloomFilter = nullptr;
+        }
+    }
     m_buckets = (int32_t*)malloc(m_hashTable.BucketCount * sizeof(int32_t));
     if (m_buckets == nullptr) {
         return false;
     }
-    void* bucketsAddress = (char*)m_gnuHashTableAddr + sizeof(GnuHashTable) + (m_hashTable.BloomSize * sizeof(size_t));
+    void* bucketsAddress = (char*)bloomAddress + (m_hashTable.BloomSize * sizeof(size_t));
     if (!ReadMemory(bucketsAddress, m_buckets, m_hashTable.BucketCount * sizeof(int32_t))) {
         Trace("ERROR: InitializeGnuHashTable buckets ReadMemory(%p) FAILED\n", bucketsAddress);
         return false;
@@ -439,15 +656,38 @@ bool
 ElfReader::GetPossibleSymbolIndex(const std::string& symbolName, std::vector<int32_t>& symbolIndexes)
 {
     uint32_t hash = Hash(symbolName);
-    int i = m_buckets[hash % m_hashTable.BucketCount] - m_hashTable.SymbolOffset;
+    if (!BloomFilterMayContain(hash)) {
+        Trace("GetPossibleSymbolIndex hash %08x not in bloom filter\n", hash);
+        return true;
+    }
+    int32_t bucket = m_buckets[hash % m_hashTable.BucketCount];
+    if (bucket < m_hashTable.SymbolOffset) {
+        Trace("GetPossibleSymbolIndex hash %08x empty bucket\n", hash);
+        return true;
+    }
+    int i = bucket - m_hashTable.SymbolOffset;
     Trace("GetPossibleSymbolIndex hash %08x index: %d BucketCount %d SymbolOffset %08x\n", hash, i, m_hashTable.BucketCount, m_hashTable.SymbolOffset);
+
+    // The chain is read a block at a time instead of an entry at a time. Once a block isn't
+    // readable the rest of the chain is read an entry at a time.
+    const int ChainBlockSize = 16;
+    int32_t chains[ChainBlockSize];
+    int blockSize = ChainBlockSize;
+    int chainsStart = i;
+    int chainsCount = 0;
     for (;; i++)
     {
-        int32_t chainVal;
-        if (!GetChain(i, &chainVal)) {
-            Trace("ERROR: GetPossibleSymbolIndex GetChain FAILED\n");
-            return false;
+        if (i >= chainsStart + chainsCount)
+        {
+            chainsStart = i;
+            chainsCount = GetChains(i, chains, blockSize);
+            if (chainsCount == 0) {
+                Trace("ERROR: GetPossibleSymbolIndex GetChain FAILED\n");
+                return false;
+            }
+            blockSize = chainsCount;
         }
+        int32_t chainVal = chains[i - chainsStart];
         if ((chainVal & 0xfffffffe) == (hash & 0xfffffffe))
         {
             symbolIndexes.push_back(i + m_hashTable.SymbolOffset);
@@ -471,12 +711,42 @@ ElfReader::Hash(const std::string& symbolName)
     return h;
 }
 
+//
+// Returns false if the symbol is definitely not in the hash table
+//
+bool
+ElfReader::BloomFilterMayContain(uint32_t hash)
+{
+    if (m_bloomFilter == nullptr) {
+        return true;
+    }
+    const uint32_t bitsPerWord = sizeof(size_t) * 8;
+    size_t word = m_bloomFilter[(hash / bitsPerWord) % (uint32_t)m_hashTable.BloomSize];
+    size_t mask = ((size_t)1 << (hash % bitsPerWord)) | ((size_t)1 << ((hash >> m_hashTable.BloomShift) % bitsPerWord));
+    return (word & mask) == mask;
+}
+
 bool
 ElfReader::GetChain(int index, int32_t* chain)
 {
     return ReadMemory((char*)m_chainsAddress + (index * sizeof(int32_t)), chain, sizeof(int32_t));
 }
 
+//
+// Reads up to count chain entries starting at index. Falls back to reading just one entry
+// if the block isn't readable (i.e. it extends past the end of the module's memory).
+// Returns the number of entries read.
+//
+int
+ElfReader::GetChains(int index, int32_t* chains, int count)
+{
+    memset(chains, 0, count * sizeof(int32_t));
+    if (count > 1 && ReadMemory((char*)m_chainsAddress + (index * sizeof(int32_t)), chains, count * sizeof(int32_t))) {
+        return count;
+    }
+    return GetChain(index, chains) ? 1 : 0;
+}
+
 //
 // String table support
 //
@@ -505,6 +775,38 @@ ElfReader::GetStringAtIndex(int index, std::string& result)
     return true;
 }
 
+//
+// Compares the string table entry with the value reading it all at once instead of a
+// character at a time.
+//
+bool
+ElfReader::IsStringAtIndex(int index, const std::string& value)
+{
+    size_t size = value.length() + 1;
+    if (index < 0 || (size_t)index + size > (size_t)m_stringTableSize) {
+        return false;
+    }
+    char buffer[256];
+    ArrayHolder<char> largeBuffer = nullptr;
+    char* data = buffer;
+    if (size > sizeof(buffer))
+    {
+        largeBuffer = new (std::nothrow) char[size];
+        if (largeBuffer == nullptr) {
+            return false;
+        }
+        data = largeBuffer;
+    }
+    memset(data, 0xff, size);
+    void* address = (char*)m_stringTableAddr + index;
+    if (!ReadMemory(address, data, size))
+    {
+        std::string result;
+        return GetStringAtIndex(index, result) && value.compare(result) == 0;
+    }
+    return memcmp(data, value.c_str(), size) == 0;
+}
+
 size_t Align4(size_t x) { return (x + 3) & ~3; }
 
 bool 
@@ -618,22 +920,16 @@ ElfReader::EnumerateLinkMapEntries(Elf_Dyn* dynamicAddr)
     }
 
     // Search dynamic entries for DT_DEBUG (r_debug entry)
+    std::vector<Elf_Dyn> entries;
+    if (!ReadDynamicEntries(dynamicAddr, entries)) {
+        return false;
+    }
     struct r_debug* rdebugAddr = nullptr;
-    for (;;)
+    for (const Elf_Dyn& dyn : entries)
     {
-        Elf_Dyn dyn;
-        if (!ReadMemory(dynamicAddr, &dyn, sizeof(dyn))) {
-            Trace("ERROR: ReadMemory(%p, %" PRIx ") dyn FAILED\n", dynamicAddr, sizeof(dyn));
-            return false;
-        }
-        Trace("DSO: dyn %p tag %" PRId " (%" PRIx ") d_ptr %" PRIxA "\n", dynamicAddr, dyn.d_tag, dyn.d_tag, dyn.d_un.d_ptr);
-        if (dyn.d_tag == DT_NULL) {
-            break;
-        }
-        else if (dyn.d_tag == DT_DEBUG) {
+        if (dyn.d_tag == DT_DEBUG) {
             rdebugAddr = reinterpret_cast<struct r_debug*>(dyn.d_un.d_ptr);
         }
-        dynamicAddr++;
     }
 
     Trace("DSO: rdebugAddr %p\n", rdebugAddr);
@@ -648,28 +944,41 @@ ElfReader::EnumerateLinkMapEntries(Elf_Dyn* dynamicAddr)
     }
 
     // Add the DSO link_map entries
+    BYTE chunk[ELF_READ_CHUNK_SIZE];
     for (struct link_map* linkMapAddr = debugEntry.r_map; linkMapAddr != nullptr;)
     {
-        struct link_map map;
-        if (!ReadMemory(linkMapAddr, &map, sizeof(map))) {
-            Trace("ERROR: ReadMemory(%p, %" PRIx ") link_map FAILED\n", linkMapAddr, sizeof(map));
-            return false;
+        // Read the rest of the page with the link_map. The loader usually allocates the module
+        // name right after its link_map so the name is often read with the same request.
+        size_t chunkSize = ELF_READ_CHUNK_SIZE - ((uint64_t)linkMapAddr & (ELF_READ_CHUNK_SIZE - 1));
+        if (chunkSize < sizeof(struct link_map) || !ReadMemory(linkMapAddr, chunk, chunkSize))
+        {
+            chunkSize = sizeof(struct link_map);
+            if (!ReadMemory(linkMapAddr, chunk, chunkSize)) {
+                Trace("ERROR: ReadMemory(%p, %" PRIx ") link_map FAILED\n", linkMapAddr, sizeof(struct link_map));
+                return false;
+            }
         }
+        struct link_map map;
+        memcpy(&map, chunk, sizeof(map));
+
         // Read the module's name and make sure the memory is added to the core dump
         std::string moduleName;
         if (map.l_name != 0)
         {
-            for (int i = 0; i < PATH_MAX; i++)
+            uint64_t nameOffset = (uint64_t)map.l_name - (uint64_t)linkMapAddr;
+            if ((uint64_t)map.l_name > (uint64_t)linkMapAddr && nameOffset < chunkSize)
             {
-                char ch;
-                if (!ReadMemory(map.l_name + i, &ch, sizeof(ch))) {
-                    Trace("DSO: ReadMemory link_map name %p + %d FAILED\n", map.l_name, i);
-                    break;
-                }
-                if (ch == '\0') {
-                    break;
+                const char* name = (const char*)chunk + nameOffset;
+                size_t length = strnlen(name, std::min<size_t>(chunkSize - nameOffset, PATH_MAX));
+                moduleName.assign(name, length);
+                if (length == chunkSize - nameOffset && length < PATH_MAX)
+                {
+                    ReadString(map.l_name + length, PATH_MAX - length, moduleName);
                 }
-                moduleName.append(1, ch);
+            }
+            else
+            {
+                ReadString(map.l_name, PATH_MAX, moduleName);
             }
         }
         Trace("\nDSO: link_map entry %p l_ld %p l_addr (Ehdr) %p l_name %p %s\n", linkMapAddr, map.l_ld, map.l_addr, map.l_name, moduleName.c_str());
@@ -683,6 +992,34 @@ ElfReader::EnumerateLinkMapEntries(Elf_Dyn* dynamicAddr)
     return true;
 }
 
+//
+// Appends the string at the address to str, reading up to the end of each page at a time
+// (see ReadMemoryChunks)
+//
+bool
+ElfReader::ReadString(const char* address, size_t maxLength, std::string& str)
+{
+    if (maxLength == 0) {
+        return true;
+    }
+    BYTE buffer[ELF_READ_CHUNK_SIZE];
+    size_t remaining = maxLength;
+    bool result = ReadMemoryChunks((uint64_t)address, buffer, sizeof(buffer), 1,
+        [this](uint64_t address, BYTE* buffer, size_t size) { return ReadMemory((const void*)address, buffer, size); },
+        [&](const BYTE* data, size_t size)
+        {
+            size = std::min(size, remaining);
+            size_t length = strnlen((const char*)data, size);
+            str.append((const char*)data, length);
+            remaining -= length;
+            return length == size && remaining > 0;
+        });
+    if (!result) {
+        Trace("DSO: ReadMemory string %p FAILED\n", address);
+    }
+    return result;
+}
+
 #endif // HOST_UNIX
 
 bool
@@ -39,6 +39,7 @@ private:
     void* m_symbolTableAddr;                // DT_SYMTAB
 
     GnuHashTable m_hashTable;               // gnu hash table info
+    size_t* m_bloomFilter;                  // gnu hash table bloom filter words or nullptr
     int32_t* m_buckets;                     // gnu hash table buckets    
     void* m_chainsAddress;
 
@@ -62,12 +63,17 @@ private:
     bool InitializeGnuHashTable();
     bool GetPossibleSymbolIndex(const std::string& symbolName, std::vector<int32_t>& symbolIndexes);
     uint32_t Hash(const std::string& symbolName);
+    bool BloomFilterMayContain(uint32_t hash);
     bool GetChain(int index, int32_t* chain);
+    int GetChains(int index, int32_t* chains, int count);
     bool GetStringAtIndex(int index, std::string& result);
+    bool IsStringAtIndex(int index, const std::string& value);
     bool ReadHeader(uint64_t baseAddress, ElfW(Ehdr)& ehdr);
     bool EnumerateProgramHeaders(ElfW(Phdr)* phdrAddr, int phnum, uint64_t baseAddress, uint64_t* ploadbias, ElfW(Dyn)** pdynamicAddr);
+    bool ReadDynamicEntries(ElfW(Dyn)* dynamicAddr, std::vector<ElfW(Dyn)>& entries);
 #ifdef HOST_UNIX
     bool EnumerateLinkMapEntries(ElfW(Dyn)* dynamicAddr);
+    bool ReadString(const char* address, size_t maxLength, std::string& str);
 #endif
 #ifdef __FreeBSD__
     virtual void VisitModule(caddr_t baseAddress, std::string& moduleName) { };
@@ -9,6 +9,7 @@
 #include <inttypes.h>
 #include <arrayholder.h>
 #include "machoreader.h"
+#include "memorychunks.h"
 
 #if TARGET_64BIT
 #define PRIx PRIx64
@@ -24,6 +25,10 @@
 #define PRIxA PRIA PRIx
 #endif
 
+// The target reads of the image path strings and headers are split at 4K boundaries, the
+// smallest page size, so they never cross into a page that isn't mapped or in the dump.
+#define MACHO_READ_CHUNK_SIZE 0x1000
+
 class MachOReaderFromFile : public MachOReader
 {
 private:
@@ -62,11 +67,16 @@ public:
 };
 
 //
-// Entry point to get an export symbol from a module file
+// Entry point to get an export symbol from a module file. If pNotFound isn't null it is set to
+// true only when the file was read and parsed but doesn't export the symbol.
 //
 extern "C" bool
-TryReadSymbolFromFile(const WCHAR* modulePath, const char* symbolName, BYTE* buffer, ULONG32 size)
+TryReadSymbolFromFile(const WCHAR* modulePath, const char* symbolName, BYTE* buffer, ULONG32 size, bool* pNotFound)
 {
+    if (pNotFound != nullptr)
+    {
+        *pNotFound = false;
+    }
     MachOReaderFromFile reader;
     if (reader.OpenFile(modulePath))
     {
@@ -78,6 +88,10 @@ TryReadSymbolFromFile(const WCHAR* modulePath, const char* symbolName, BYTE* buf
             {
                 return reader.ReadMemory((void*)symbolOffset, buffer, size);
             }
+            if (pNotFound != nullptr)
+            {
+                *pNotFound = module.ReadSymbolTable();
+            }
         }
     }
     return false;
@@ -143,6 +157,17 @@ TryGetSymbolWithCallback(ReadMemoryCallback readMemory, uint64_t baseAddress, co
     return false;
 }
 
+//
+// Get the build id of the module with a memory read callback
+//
+extern "C" bool
+TryGetBuildIdWithCallback(ReadMemoryCallback readMemory, uint64_t baseAddress, BYTE* buffer, ULONG bufferSize, PULONG pBuildSize)
+{
+    MachOReaderWithCallback reader(readMemory);
+    MachOModule module(reader, false, baseAddress);
+    return module.GetBuildId(buffer, bufferSize, pBuildSize);
+}
+
 class MachOReaderExport : public MachOReader
 {
 private:
@@ -200,6 +225,110 @@ TryGetBuildId(ICorDebugDataTarget* dataTarget, uint64_t baseAddress, BYTE* buffe
     return module.GetBuildId(buffer, bufferSize, pBuildSize);
 }
 
+//
+// Parsed export symbol tables of a module that can be reused to resolve any number of names
+// (and the build id) without re-reading the header, load commands and symbol table for each
+// lookup.
+//
+class MachOSymbolIndex
+{
+private:
+    MachOReader* m_reader;
+    MachOModule m_module;
+    bool m_headerValid;
+
+public:
+    MachOSymbolIndex(MachOReader* reader, uint64_t baseAddress) :
+        m_reader(reader),
+        m_module(*reader, false, baseAddress)
+    {
+        m_headerValid = m_module.ReadHeader();
+    }
+
+    ~MachOSymbolIndex()
+    {
+        delete m_reader;
+    }
+
+    int TryGetSymbols(int count, const char* const* symbolNames, uint64_t* symbolAddresses)
+    {
+        int found = 0;
+        for (int i = 0; i < count; i++)
+        {
+            if (m_headerValid && m_module.TryLookupSymbol(symbolNames[i], &symbolAddresses[i]))
+            {
+                found++;
+            }
+            else
+            {
+                symbolAddresses[i] = 0;
+            }
+        }
+        return found;
+    }
+
+    bool GetBuildId(BYTE* buffer, ULONG bufferSize, PULONG pBuildSize)
+    {
+        return m_headerValid && m_module.GetBuildId(buffer, bufferSize, pBuildSize);
+    }
+};
+
+static void*
+NewSymbolIndex(MachOReader* reader, uint64_t baseAddress)
+{
+    if (reader == nullptr)
+    {
+        return nullptr;
+    }
+    MachOSymbolIndex* symbolIndex = new (std::nothrow) MachOSymbolIndex(reader, baseAddress);
+    if (symbolIndex == nullptr)
+    {
+        delete reader;
+    }
+    return symbolIndex;
+}
+
+//
+// Entry points to create a symbol index for the module at the base address. Returns nullptr
+// only if out of memory; lookups on an index of a module that can't be parsed just fail.
+//
+extern "C" void*
+CreateSymbolIndexWithCallback(ReadMemoryCallback readMemory, uint64_t baseAddress)
+{
+    return NewSymbolIndex(new (std::nothrow) MachOReaderWithCallback(readMemory), baseAddress);
+}
+
+extern "C" void*
+CreateSymbolIndex(ICorDebugDataTarget* dataTarget, uint64_t baseAddress)
+{
+    return NewSymbolIndex(new (std::nothrow) MachOReaderExport(dataTarget), baseAddress);
+}
+
+//
+// Resolves a batch of export symbols from a symbol index. The addresses of the symbols that
+// aren't found are set to 0. Returns the number of symbols found.
+//
+extern "C" int
+TryGetSymbolsFromIndex(void* symbolIndex, int count, const char* const* symbolNames, uint64_t* symbolAddresses)
+{
+    return ((MachOSymbolIndex*)symbolIndex)->TryGetSymbols(count, symbolNames, symbolAddresses);
+}
+
+//
+// Get the build id of the module from a symbol index
+//
+extern "C" bool
+TryGetBuildIdFromIndex(void* symbolIndex, BYTE* buffer, ULONG bufferSize, PULONG pBuildSize)
+{
+    return ((MachOSymbolIndex*)symbolIndex)->GetBuildId(buffer, bufferSize, pBuildSize);
+}
+
+extern "C" void
+DestroySymbolIndex(void* symbolIndex)
+{
+    delete (MachOSymbolIndex*)symbolIndex;
+}
+
 //--------------------------------------------------------------------
 // MachO module 
 //--------------------------------------------------------------------
@@ -210,9 +339,15 @@ MachOModule::MachOModule(MachOReader& reader, bool isFileLayout, mach_vm_address
     m_baseAddress(baseAddress),
     m_loadBias(0),
     m_commands(nullptr),
+    m_uuidCommand(nullptr),
     m_symtabCommand(nullptr),
+    m_dysymtabCommand(nullptr),
     m_nlists(nullptr),
-    m_strtabAddress(0)
+    m_strtabAddress(0),
+    m_strtab(nullptr),
+    m_strtabSize(0),
+    m_symbolIndex(nullptr),
+    m_symbolIndexMask(0)
 {
     if (header != nullptr) {
         m_header = *header;
@@ -232,19 +367,43 @@ MachOModule::~MachOModule()
         free(m_nlists);
         m_nlists = nullptr;
     }
+    if (m_strtab != nullptr) {
+        free(m_strtab);
+        m_strtab = nullptr;
+    }
+    if (m_symbolIndex != nullptr) {
+        free(m_symbolIndex);
+        m_symbolIndex = nullptr;
+    }
 }
 
+//
+// Reads and validates the module header. If the caller already read the start of the module
+// (data/size) the header and the load commands that fit are taken from that instead.
+//
 bool
-MachOModule::ReadHeader()
+MachOModule::ReadHeader(const BYTE* data, size_t size)
 {
     _ASSERTE(sizeof(m_header) == sizeof(mach_header_64));
-    if (!m_reader.ReadMemory((void*)m_baseAddress, &m_header, sizeof(mach_header_64)))
+    if (data != nullptr && size >= sizeof(mach_header_64))
+    {
+        memcpy(&m_header, data, sizeof(mach_header_64));
+    }
+    else if (!m_reader.ReadMemory((void*)m_baseAddress, &m_header, sizeof(mach_header_64)))
     {
         m_reader.Trace("ERROR: failed to read header at %p\n", (void*)m_baseAddress);
         return false;
     }
     m_reader.Trace("ReadHeader: magic %08x cputype %08x ncmds %d sizeofcmds %d\n", m_header.magic, m_header.cputype, m_header.ncmds, m_header.sizeofcmds);
-    return m_header.magic == 0xfeedfacf;
+    if (m_header.magic != 0xfeedfacf)
+    {
+        return false;
+    }
+    if (data != nullptr && size >= sizeof(mach_header_64) && m_header.sizeofcmds <= size - sizeof(mach_header_64))
+    {
+        SetLoadCommands(data + sizeof(mach_header_64));
+    }
+    return true;
 }
 
 bool
@@ -257,6 +416,20 @@ MachOModule::TryLookupSymbol(const char* symbolName, uint64_t* symbolValue)
         _ASSERTE(m_nlists != nullptr);
         _ASSERTE(m_strtabAddress != 0);
 
+        if (m_symbolIndex != nullptr)
+        {
+            int index = FindSymbol(symbolName);
+            if (index >= 0)
+            {
+                m_reader.Trace("SYM: Found '%s' in symbol index\n", symbolName);
+                *symbolValue = m_loadBias + m_nlists[index].n_value;
+                return true;
+            }
+            m_reader.Trace("SYM: Missed '%s' in symbol index\n", symbolName);
+            *symbolValue = 0;
+            return false;
+        }
+
         // First, search just the "external" export symbols 
         if (TryLookupSymbol(m_dysymtabCommand->iextdefsym, m_dysymtabCommand->nextdefsym, symbolName, symbolValue))
         {
@@ -356,77 +529,99 @@ MachOModule::ReadLoadCommands()
         if (!m_reader.ReadMemory(commandsAddress, m_commands, m_header.sizeofcmds))
         {
             m_reader.Trace("ERROR: Failed to read load commands at %p of %d\n", commandsAddress, m_header.sizeofcmds);
+            free(m_commands);
+            m_commands = nullptr;
             return false;
         }
-        load_command* command = m_commands;
+        ParseLoadCommands();
+    }
 
-        for (int i = 0; i < m_header.ncmds; i++)
-        {
-            m_reader.TraceVerbose("CMD: load command cmd %02x (%d) size %d\n", command->cmd, command->cmd, command->cmdsize);
+    return true;
+}
 
-            switch (command->cmd)
-            {
-            case LC_UUID:
-                m_uuidCommand = (uuid_command*)command;
-                break;
+void
+MachOModule::SetLoadCommands(const void* commands)
+{
+    _ASSERTE(m_commands == nullptr);
+    m_commands = (load_command*)malloc(m_header.sizeofcmds);
+    if (m_commands == nullptr)
+    {
+        // ReadLoadCommands will try again when they are needed
+        return;
+    }
+    memcpy(m_commands, commands, m_header.sizeofcmds);
+    ParseLoadCommands();
+}
 
-            case LC_SYMTAB:
-                m_symtabCommand = (symtab_command*)command;
-                break;
+void
+MachOModule::ParseLoadCommands()
+{
+    load_command* command = m_commands;
 
-            case LC_DYSYMTAB:
-                m_dysymtabCommand = (dysymtab_command*)command;
-                break;
+    for (int i = 0; i < m_header.ncmds; i++)
+    {
+        m_reader.TraceVerbose("CMD: load command cmd %02x (%d) size %d\n", command->cmd, command->cmd, command->cmdsize);
 
-            case LC_SEGMENT_64:
-                segment_command_64* segment = (segment_command_64*)command;
-                m_segments.push_back(segment);
+        switch (command->cmd)
+        {
+        case LC_UUID:
+            m_uuidCommand = (uuid_command*)command;
+            break;
 
-                // Calculate the load bias for the module. This is the value to add to the vmaddr of a
-                // segment to get the actual address.
-                if (!m_isFileLayout)
-                {
-                    if (strcmp(segment->segname, SEG_TEXT) == 0)
-                    {
-                        m_loadBias = m_baseAddress - segment->vmaddr;
-                    }
-                }
+        case LC_SYMTAB:
+            m_symtabCommand = (symtab_command*)command;
+            break;
+
+        case LC_DYSYMTAB:
+            m_dysymtabCommand = (dysymtab_command*)command;
+            break;
+
+        case LC_SEGMENT_64:
+            segment_command_64* segment = (segment_command_64*)command;
+            m_segments.push_back(segment);
 
-                m_reader.TraceVerbose("CMD: vmaddr %016llx vmsize %016llx fileoff %016llx filesize %016llx nsects %d max %c%c%c init %c%c%c %02x %s\n",
-                    segment->vmaddr,
-                    segment->vmsize,
-                    segment->fileoff,
-                    segment->filesize,
-                    segment->nsects,
-                    (segment->maxprot & VM_PROT_READ) ? 'r' : '-',
-                    (segment->maxprot & VM_PROT_WRITE) ? 'w' : '-',
-                    (segment->maxprot & VM_PROT_EXECUTE) ? 'x' : '-',
-                    (segment->initprot & VM_PROT_READ) ? 'r' : '-',
-                    (segment->initprot & VM_PROT_WRITE) ? 'w' : '-',
-                    (segment->initprot & VM_PROT_EXECUTE) ? 'x' : '-',
-                    segment->flags,
-                    segment->segname);
-
-                section_64* section = (section_64*)((uint64_t)segment + sizeof(segment_command_64));
-                for (int s = 0; s < segment->nsects; s++, section++)
+            // Calculate the load bias for the module. This is the value to add to the vmaddr of a
+            // segment to get the actual address.
+            if (!m_isFileLayout)
+            {
+                if (strcmp(segment->segname, SEG_TEXT) == 0)
                 {
-                    m_reader.TraceVerbose("     addr %016llx size %016llx off %08x align %02x flags %02x %s\n",
-                        section->addr,
-                        section->size,
-                        section->offset,
-                        section->align,
-                        section->flags,
-                        section->sectname);
+                    m_loadBias = m_baseAddress - segment->vmaddr;
                 }
-                break;
             }
-            // Get next load command
-            command = (load_command*)((char*)command + command->cmdsize);
+
+            m_reader.TraceVerbose("CMD: vmaddr %016llx vmsize %016llx fileoff %016llx filesize %016llx nsects %d max %c%c%c init %c%c%c %02x %s\n",
+                segment->vmaddr,
+                segment->vmsize,
+                segment->fileoff,
+                segment->filesize,
+                segment->nsects,
+                (segment->maxprot & VM_PROT_READ) ? 'r' : '-',
+                (segment->maxprot & VM_PROT_WRITE) ? 'w' : '-',
+                (segment->maxprot & VM_PROT_EXECUTE) ? 'x' : '-',
+                (segment->initprot & VM_PROT_READ) ? 'r' : '-',
+                (segment->initprot & VM_PROT_WRITE) ? 'w' : '-',
+                (segment->initprot & VM_PROT_EXECUTE) ? 'x' : '-',
+                segment->flags,
+                segment->segname);
+
+            section_64* section = (section_64*)((uint64_t)segment + sizeof(segment_command_64));
+            for (int s = 0; s < segment->nsects; s++, section++)
+            {
+                m_reader.TraceVerbose("     addr %016llx size %016llx off %08x align %02x flags %02x %s\n",
+                    section->addr,
+                    section->size,
+                    section->offset,
+                    section->align,
+                    section->flags,
+                    section->sectname);
+            }
+            break;
         }
-        m_reader.TraceVerbose("CMD: load bias %016llx\n", m_loadBias);
+        // Get next load command
+        command = (load_command*)((char*)command + command->cmdsize);
     }
-
-    return true;
+    m_reader.TraceVerbose("CMD: load bias %016llx\n", m_loadBias);
 }
 
 bool
@@ -465,15 +660,140 @@ MachOModule::ReadSymbolTable()
         if (!m_reader.ReadMemory(symbolTableAddress, m_nlists, symtabSize))
         {
             m_reader.Trace("ERROR: Failed to read symtab at %p of %zu\n", symbolTableAddress, symtabSize);
+            free(m_nlists);
+            m_nlists = nullptr;
             return false;
         }
 
         // Save the symbol string table address.
         m_strtabAddress = GetAddressFromFileOffset(m_symtabCommand->stroff);
+
+        // Read the whole string table and index the symbol names. If that fails, the lookups fall
+        // back to searching the symbols and reading the names from the target.
+        if (ReadStringTable())
+        {
+            BuildSymbolIndex();
+        }
+    }
+    return true;
+}
+
+bool
+MachOModule::ReadStringTable()
+{
+    _ASSERTE(m_strtab == nullptr);
+    uint32_t strsize = m_symtabCommand->strsize;
+    m_strtab = (char*)malloc((size_t)strsize + 1);
+    if (m_strtab == nullptr)
+    {
+        m_reader.Trace("ERROR: Failed to allocate %u byte string table\n", strsize);
+        return false;
+    }
+    if (!m_reader.ReadMemory((void*)m_strtabAddress, m_strtab, strsize))
+    {
+        m_reader.Trace("ERROR: Failed to read string table at %p of %u\n", (void*)m_strtabAddress, strsize);
+        free(m_strtab);
+        m_strtab = nullptr;
+        return false;
     }
+    // Make sure the last name is terminated
+    m_strtab[strsize] = '\0';
+    m_strtabSize = strsize;
     return true;
 }
 
+static uint32_t
+HashSymbolName(const char* name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (; *name != '\0'; name++)
+    {
+        hash = (hash ^ (uint8_t)*name) * 16777619u;
+    }
+    return hash;
+}
+
+void
+MachOModule::BuildSymbolIndex()
+{
+    _ASSERTE(m_symbolIndex == nullptr);
+    uint32_t nsyms = m_symtabCommand->nsyms;
+    if (nsyms > INT32_MAX / 2)
+    {
+        return;
+    }
+    // Keep the table at most half full
+    uint32_t capacity = 16;
+    while (capacity < nsyms * 2)
+    {
+        capacity <<= 1;
+    }
+    m_symbolIndex = (int32_t*)malloc(capacity * sizeof(int32_t));
+    if (m_symbolIndex == nullptr)
+    {
+        m_reader.Trace("ERROR: Failed to allocate %u entry symbol index\n", capacity);
+        return;
+    }
+    memset(m_symbolIndex, 0xff, capacity * sizeof(int32_t));
+    m_symbolIndexMask = capacity - 1;
+
+    // Add the "external" export symbols first so they win over any other symbol with the same
+    // name, then the rest in order; the same precedence as searching the symbols linearly.
+    if (m_dysymtabCommand != nullptr)
+    {
+        AddSymbolsToIndex(m_dysymtabCommand->iextdefsym, m_dysymtabCommand->nextdefsym);
+    }
+    AddSymbolsToIndex(0, nsyms);
+}
+
+void
+MachOModule::AddSymbolsToIndex(uint32_t start, uint32_t nsyms)
+{
+    uint32_t totalSymbols = m_symtabCommand->nsyms;
+    if (start > totalSymbols || nsyms > (totalSymbols - start))
+    {
+        return;
+    }
+    for (uint32_t i = start; i < start + nsyms; i++)
+    {
+        const char* name = GetStrippedSymbolName(i);
+        if (*name == '\0')
+        {
+            continue;
+        }
+        uint32_t slot = HashSymbolName(name) & m_symbolIndexMask;
+        while (m_symbolIndex[slot] >= 0)
+        {
+            if (strcmp(GetStrippedSymbolName(m_symbolIndex[slot]), name) == 0)
+            {
+                break;
+            }
+            slot = (slot + 1) & m_symbolIndexMask;
+        }
+        if (m_symbolIndex[slot] < 0)
+        {
+            m_symbolIndex[slot] = (int32_t)i;
+        }
+    }
+}
+
+int
+MachOModule::FindSymbol(const char* symbolName)
+{
+    _ASSERTE(m_symbolIndex != nullptr);
+    uint32_t slot = HashSymbolName(symbolName) & m_symbolIndexMask;
+    while (m_symbolIndex[slot] >= 0)
+    {
+        if (strcmp(GetStrippedSymbolName(m_symbolIndex[slot]), symbolName) == 0)
+        {
+            return m_symbolIndex[slot];
+        }
+        slot = (slot + 1) & m_symbolIndexMask;
+    }
+    return -1;
+}
+
 uint64_t
 MachOModule::GetAddressFromFileOffset(uint32_t offset)
 {
@@ -491,9 +811,25 @@ MachOModule::GetAddressFromFileOffset(uint32_t offset)
     return m_loadBias + offset;
 }
 
+const char*
+MachOModule::GetStrippedSymbolName(int index)
+{
+    _ASSERTE(m_strtab != nullptr);
+    uint32_t strx = m_nlists[index].n_un.n_strx;
+    const char* name = strx < m_strtabSize ? m_strtab + strx : "";
+
+    // Skip the leading underscores to match Linux externs
+    return name[0] == '_' ? name + 1 : name;
+}
+
 std::string
 MachOModule::GetSymbolName(int index)
 {
+    if (m_strtab != nullptr)
+    {
+        uint32_t strx = m_nlists[index].n_un.n_strx;
+        return std::string(strx < m_strtabSize ? m_strtab + strx : "");
+    }
     uint64_t symbolNameAddress = m_strtabAddress + m_nlists[index].n_un.n_strx;
     std::string result;
     while (true)
@@ -570,8 +906,17 @@ MachOReader::TryRegisterModule(const struct mach_header* imageAddress, const cha
         return false;
     }
 
+    // Read the header and the load commands that fit in the rest of its page with one request
+    uint64_t headerAddress = (uint64_t)imageAddress;
+    size_t readSize = MACHO_READ_CHUNK_SIZE - (headerAddress & (MACHO_READ_CHUNK_SIZE - 1));
+    BYTE buffer[MACHO_READ_CHUNK_SIZE];
+    if (readSize < sizeof(mach_header_64) || !ReadMemory((void*)headerAddress, buffer, readSize))
+    {
+        // Fall back to reading just the header
+        readSize = 0;
+    }
     MachOModule module(*this, false, (mach_vm_address_t)imageAddress, nullptr, &imagePath);
-    if (!module.ReadHeader())
+    if (!module.ReadHeader(buffer, readSize))
     {
         return false;
     }
@@ -595,19 +940,24 @@ MachOReader::TryRegisterModule(const struct mach_header* imageAddress, const cha
 bool
 MachOReader::ReadString(const char* address, std::string& str)
 {
-    for (int i = 0; i < MAX_LONGPATH; i++)
-    {
-        char c = 0;
-        if (!ReadMemory((void*)(address + i), &c, sizeof(char)))
-        {
-            Trace("ERROR: Failed to read string at %p\n", (void*)(address + i));
-            return false;
-        }
-        if (c == '\0')
+    // Read up to the end of each page at a time (see ReadMemoryChunks)
+    BYTE buffer[MACHO_READ_CHUNK_SIZE];
+    bool result = ReadMemoryChunks((uint64_t)address, buffer, sizeof(buffer), 1,
+        [this](uint64_t address, BYTE* buffer, size_t size) { return ReadMemory((void*)address, buffer, size); },
+        [&](const BYTE* data, size_t size)
         {
-            break;
-        }
-        str.append(1, c);
+            size_t length = strnlen((const char*)data, size);
+            str.append((const char*)data, length);
+            return length == size && str.length() < MAX_LONGPATH;
+        });
+    if (!result)
+    {
+        Trace("ERROR: Failed to read string at %p\n", (void*)address);
+        return false;
+    }
+    if (str.length() > MAX_LONGPATH)
+    {
+        str.resize(MAX_LONGPATH);
     }
     return true;
 }
@@ -1,10 +1,14 @@
 // Licensed to the .NET Foundation under one or more agreements.
 // The .NET Foundation licenses this file to you under the MIT license.
 
+#ifdef __APPLE__
 #include <mach/mach.h>
 #include <mach-o/loader.h>
 #include <mach-o/nlist.h>
 #include <mach-o/dyld_images.h>
+#else
+#include "machotypes.h"
+#endif
 #include <string>
 #include <vector>
 
@@ -27,6 +31,10 @@ private:
     dysymtab_command* m_dysymtabCommand;
     nlist_64* m_nlists;
     uint64_t m_strtabAddress;
+    char* m_strtab;                 // symbol string table or nullptr if it couldn't be read in one piece
+    uint32_t m_strtabSize;
+    int32_t* m_symbolIndex;         // open addressing hash table of the stripped names to nlist indexes
+    uint32_t m_symbolIndexMask;
 
 public:
     MachOModule(MachOReader& reader, bool isFileLayout, mach_vm_address_t baseAddress, mach_header_64* header = nullptr, std::string* name = nullptr);
@@ -37,18 +45,25 @@ public:
     inline const mach_header_64& Header() const { return m_header; }
     inline const std::string& Name() const { return m_name; }
 
-    bool ReadHeader();
+    bool ReadHeader(const BYTE* data = nullptr, size_t size = 0);
     bool TryLookupSymbol(const char* symbolName, uint64_t* symbolValue);
     bool TryLookupSymbol(int start, int nsyms, const char* symbolName, uint64_t* symbolValue);
     bool GetBuildId(BYTE* buffer, ULONG bufferSize, PULONG pBuildSize);
     bool EnumerateSegments();
+    bool ReadSymbolTable();
 
 private:
     inline void SetName(std::string& name) { m_name = name; }
 
-    bool ReadSymbolTable();
+    bool ReadStringTable();
+    void BuildSymbolIndex();
+    void AddSymbolsToIndex(uint32_t start, uint32_t nsyms);
+    int FindSymbol(const char* symbolName);
     bool ReadLoadCommands();
+    void SetLoadCommands(const void* commands);
+    void ParseLoadCommands();
     uint64_t GetAddressFromFileOffset(uint32_t offset);
+    const char* GetStrippedSymbolName(int index);
     std::string GetSymbolName(int index);
 };
 
@@ -57,6 +72,7 @@ class MachOReader
     friend MachOModule;
 public:
     MachOReader();
+    virtual ~MachOReader() { };
     bool EnumerateModules(mach_vm_address_t dyldInfoAddress);
 
 private:
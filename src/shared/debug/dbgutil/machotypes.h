@@ -0,0 +1,189 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+//
+// The subset of the Mach-O and dyld definitions (mach-o/loader.h, mach-o/nlist.h and
+// mach-o/dyld_images.h) used by the Mach-O reader so it can be built and tested on
+// hosts without the macOS headers. The layouts match the 64-bit macOS headers.
+//
+
+#pragma once
+
+#include <stdint.h>
+
+typedef uint64_t mach_vm_address_t;
+typedef int vm_prot_t;
+typedef int cpu_type_t;
+typedef int cpu_subtype_t;
+
+#define VM_PROT_READ        0x01
+#define VM_PROT_WRITE       0x02
+#define VM_PROT_EXECUTE     0x04
+
+#define CPU_ARCH_ABI64      0x01000000
+#define CPU_TYPE_X86_64     (7 | CPU_ARCH_ABI64)
+
+#define MH_MAGIC_64         0xfeedfacf
+#define MH_DYLIB            0x6
+
+#define LC_SYMTAB           0x2
+#define LC_DYSYMTAB         0xb
+#define LC_SEGMENT_64       0x19
+#define LC_UUID             0x1b
+
+#define SEG_TEXT            "__TEXT"
+#define SEG_LINKEDIT        "__LINKEDIT"
+
+#define N_EXT               0x01
+#define N_SECT              0xe
+
+struct mach_header
+{
+    uint32_t magic;
+    cpu_type_t cputype;
+    cpu_subtype_t cpusubtype;
+    uint32_t filetype;
+    uint32_t ncmds;
+    uint32_t sizeofcmds;
+    uint32_t flags;
+};
+
+struct mach_header_64
+{
+    uint32_t magic;
+    cpu_type_t cputype;
+    cpu_subtype_t cpusubtype;
+    uint32_t filetype;
+    uint32_t ncmds;
+    uint32_t sizeofcmds;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+struct load_command
+{
+    uint32_t cmd;
+    uint32_t cmdsize;
+};
+
+struct segment_command_64
+{
+    uint32_t cmd;
+    uint32_t cmdsize;
+    char segname[16];
+    uint64_t vmaddr;
+    uint64_t vmsize;
+    uint64_t fileoff;
+    uint64_t filesize;
+    vm_prot_t maxprot;
+    vm_prot_t initprot;
+    uint32_t nsects;
+    uint32_t flags;
+};
+
+struct section_64
+{
+    char sectname[16];
+    char segname[16];
+    uint64_t addr;
+    uint64_t size;
+    uint32_t offset;
+    uint32_t align;
+    uint32_t reloff;
+    uint32_t nreloc;
+    uint32_t flags;
+    uint32_t reserved1;
+    uint32_t reserved2;
+    uint32_t reserved3;
+};
+
+struct symtab_command
+{
+    uint32_t cmd;
+    uint32_t cmdsize;
+    uint32_t symoff;
+    uint32_t nsyms;
+    uint32_t stroff;
+    uint32_t strsize;
+};
+
+struct dysymtab_command
+{
+    uint32_t cmd;
+    uint32_t cmdsize;
+    uint32_t ilocalsym;
+    uint32_t nlocalsym;
+    uint32_t iextdefsym;
+    uint32_t nextdefsym;
+    uint32_t iundefsym;
+    uint32_t nundefsym;
+    uint32_t tocoff;
+    uint32_t ntoc;
+    uint32_t modtaboff;
+    uint32_t nmodtab;
+    uint32_t extrefsymoff;
+    uint32_t nextrefsyms;
+    uint32_t indirectsymoff;
+    uint32_t nindirectsyms;
+    uint32_t extreloff;
+    uint32_t nextrel;
+    uint32_t locreloff;
+    uint32_t nlocrel;
+};
+
+struct uuid_command
+{
+    uint32_t cmd;
+    uint32_t cmdsize;
+    uint8_t uuid[16];
+};
+
+struct nlist_64
+{
+    union
+    {
+        uint32_t n_strx;
+    } n_un;
+    uint8_t n_type;
+    uint8_t n_sect;
+    uint16_t n_desc;
+    uint64_t n_value;
+};
+
+struct dyld_image_info
+{
+    const struct mach_header* imageLoadAddress;
+    const char* imageFilePath;
+    uintptr_t imageFileModDate;
+};
+
+// Only up to dyldPath (version 15); the fields after it aren't used by the reader
+struct dyld_all_image_infos
+{
+    uint32_t version;
+    uint32_t infoArrayCount;
+    const struct dyld_image_info* infoArray;
+    void* notification;
+    bool processDetachedFromSharedRegion;
+    bool libSystemInitialized;
+    const struct mach_header* dyldImageLoadAddress;
+    void* jitInfo;
+    const char* dyldVersion;
+    const char* errorMessage;
+    uintptr_t terminationFlags;
+    void* coreSymbolicationShmPage;
+    uintptr_t systemOrderFlag;
+    uintptr_t uuidArrayCount;
+    const void* uuidArray;
+    struct dyld_all_image_infos* dyldAllImageInfosAddress;
+    uintptr_t initialImageCount;
+    uintptr_t errorKind;
+    const char* errorClientOfDylibPath;
+    const char* errorTargetDylibPath;
+    const char* errorSymbol;
+    uintptr_t sharedCacheSlide;
+    uint8_t sharedCacheUUID[16];
+    uintptr_t sharedCacheBaseAddress;
+    uint64_t infoArrayChangeTimestamp;
+    const char* dyldPath;
+};
@@ -0,0 +1,53 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Reads the target memory forward from the address and passes each chunk read to the
+// visitor (const BYTE* data, size_t size) until it returns false. A read ends at the next
+// multiple of the chunk size, initially the buffer size (a page), so it never runs into the
+// next, possibly unmapped, page. When a read fails only the start of the page may be
+// readable: the chunk size shrinks (page, 256, 16, then 1 byte) and stays small for the
+// rest of the reads. Reads are whole elements of elementSize bytes so a chunk never splits
+// one. Returns false if an element couldn't be read.
+//
+template <typename TReadMemory, typename TVisitor>
+bool
+ReadMemoryChunks(
+    uint64_t address,
+    BYTE* buffer,
+    size_t bufferSize,
+    size_t elementSize,
+    TReadMemory readMemory,
+    TVisitor visitor)
+{
+    size_t chunkSize = bufferSize;
+    for (;;)
+    {
+        size_t readSize = chunkSize - (address & (chunkSize - 1));
+        readSize -= readSize % elementSize;
+        if (readSize == 0)
+        {
+            readSize = elementSize;
+        }
+        if (!readMemory(address, buffer, readSize))
+        {
+            // Nothing smaller than an element can be read
+            if (readSize == elementSize)
+            {
+                return false;
+            }
+            chunkSize = chunkSize > 16 ? chunkSize / 16 : 1;
+            continue;
+        }
+        if (!visitor(buffer, readSize))
+        {
+            return true;
+        }
+        address += readSize;
+    }
+}
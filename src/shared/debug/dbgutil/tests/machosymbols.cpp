@@ -0,0 +1,279 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+//
+// Checks that the Mach-O symbol lookups through the symbol name index return the same
+// symbols as the linear search of the external and then all the symbols, including the
+// names that aren't in the module, and that ReadHeader uses the load commands in the
+// header bytes it is passed.
+//
+
+#include <windows.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "machoreader.h"
+#include "testharness.h"
+
+// Symbol table layout of the sample module: locals, then externals, then undefined symbols
+const uint32_t LocalCount = 1000;
+const uint32_t ExternalCount = 700;
+const uint32_t UndefinedCount = 300;
+const uint32_t SymbolCount = LocalCount + ExternalCount + UndefinedCount;
+const uint64_t LinkEditOffset = 0x1000;
+const uint64_t SymbolValueBase = 0x10000;
+
+//
+// Builds a sample module in the file layout. Some local symbols have the same names as
+// externals (the external wins), some are duplicated and some have no leading underscore.
+//
+static void
+CreateSampleModule(std::vector<BYTE>& image, std::vector<std::string>& names)
+{
+    for (uint32_t i = 0; i < LocalCount; i++)
+    {
+        char name[64];
+        if (i % 7 == 0) {
+            snprintf(name, sizeof(name), "_ext_%u", i % ExternalCount);
+        }
+        else if (i % 11 == 0) {
+            snprintf(name, sizeof(name), "noscore_%u", i);
+        }
+        else if (i % 13 == 0) {
+            snprintf(name, sizeof(name), "_dup_%u", i % 50);
+        }
+        else {
+            snprintf(name, sizeof(name), "_local_%u", i);
+        }
+        names.push_back(name);
+    }
+    for (uint32_t i = 0; i < ExternalCount; i++)
+    {
+        names.push_back("_ext_" + std::to_string(i));
+    }
+    for (uint32_t i = 0; i < UndefinedCount; i++)
+    {
+        names.push_back("_undef_" + std::to_string(i));
+    }
+    names[LocalCount + 5] = "_DotNetRuntimeInfo";
+
+    std::vector<char> strtab(1, '\0');
+    std::vector<uint32_t> strx;
+    for (const std::string& name : names)
+    {
+        strx.push_back((uint32_t)strtab.size());
+        strtab.insert(strtab.end(), name.c_str(), name.c_str() + name.length() + 1);
+    }
+    strtab.resize((strtab.size() + 7) & ~7);
+
+    uint64_t symoff = LinkEditOffset;
+    uint64_t stroff = symoff + SymbolCount * sizeof(nlist_64);
+    uint64_t fileSize = stroff + strtab.size();
+    image.assign(fileSize, 0);
+
+    struct
+    {
+        mach_header_64 header;
+        segment_command_64 text;
+        segment_command_64 linkedit;
+        symtab_command symtab;
+        dysymtab_command dysymtab;
+        uuid_command uuid;
+    } commands;
+    memset(&commands, 0, sizeof(commands));
+
+    commands.header.magic = MH_MAGIC_64;
+    commands.header.cputype = CPU_TYPE_X86_64;
+    commands.header.filetype = MH_DYLIB;
+    commands.header.ncmds = 5;
+    commands.header.sizeofcmds = sizeof(commands) - sizeof(mach_header_64);
+
+    commands.text.cmd = LC_SEGMENT_64;
+    commands.text.cmdsize = sizeof(segment_command_64);
+    strcpy(commands.text.segname, SEG_TEXT);
+    commands.text.vmsize = LinkEditOffset;
+    commands.text.filesize = LinkEditOffset;
+
+    commands.linkedit.cmd = LC_SEGMENT_64;
+    commands.linkedit.cmdsize = sizeof(segment_command_64);
+    strcpy(commands.linkedit.segname, SEG_LINKEDIT);
+    commands.linkedit.vmaddr = LinkEditOffset;
+    commands.linkedit.vmsize = fileSize - LinkEditOffset;
+    commands.linkedit.fileoff = LinkEditOffset;
+    commands.linkedit.filesize = fileSize - LinkEditOffset;
+
+    commands.symtab.cmd = LC_SYMTAB;
+    commands.symtab.cmdsize = sizeof(symtab_command);
+    commands.symtab.symoff = (uint32_t)symoff;
+    commands.symtab.nsyms = SymbolCount;
+    commands.symtab.stroff = (uint32_t)stroff;
+    commands.symtab.strsize = (uint32_t)strtab.size();
+
+    commands.dysymtab.cmd = LC_DYSYMTAB;
+    commands.dysymtab.cmdsize = sizeof(dysymtab_command);
+    commands.dysymtab.nlocalsym = LocalCount;
+    commands.dysymtab.iextdefsym = LocalCount;
+    commands.dysymtab.nextdefsym = ExternalCount;
+    commands.dysymtab.iundefsym = LocalCount + ExternalCount;
+    commands.dysymtab.nundefsym = UndefinedCount;
+
+    commands.uuid.cmd = LC_UUID;
+    commands.uuid.cmdsize = sizeof(uuid_command);
+    for (int i = 0; i < 16; i++)
+    {
+        commands.uuid.uuid[i] = (uint8_t)i;
+    }
+    memcpy(image.data(), &commands, sizeof(commands));
+
+    nlist_64* nlists = (nlist_64*)(image.data() + symoff);
+    for (uint32_t i = 0; i < SymbolCount; i++)
+    {
+        nlists[i].n_un.n_strx = strx[i];
+        nlists[i].n_type = N_SECT | N_EXT;
+        nlists[i].n_sect = 1;
+        nlists[i].n_value = SymbolValueBase + i * 16;
+    }
+    memcpy(image.data() + stroff, strtab.data(), strtab.size());
+}
+
+class MachOReaderFromBuffer : public MachOReader
+{
+private:
+    const std::vector<BYTE>& m_image;
+    int m_headerReads;
+
+public:
+    MachOReaderFromBuffer(const std::vector<BYTE>& image) :
+        m_image(image),
+        m_headerReads(0)
+    {
+    }
+
+    // The number of reads of the header and load commands
+    int HeaderReads() const { return m_headerReads; }
+
+private:
+    virtual bool ReadMemory(void* address, void* buffer, size_t size)
+    {
+        size_t offset = (size_t)address;
+        if (offset < LinkEditOffset)
+        {
+            m_headerReads++;
+        }
+        if (offset >= m_image.size() || size > (m_image.size() - offset))
+        {
+            return false;
+        }
+        memcpy(buffer, m_image.data() + offset, size);
+        return true;
+    }
+};
+
+//
+// The lookup without the index: the external symbols first, then all of them
+//
+static bool
+LinearLookupSymbol(MachOModule& module, const char* symbolName, uint64_t* symbolValue)
+{
+    return module.TryLookupSymbol(LocalCount, ExternalCount, symbolName, symbolValue) ||
+        module.TryLookupSymbol(0, SymbolCount, symbolName, symbolValue);
+}
+
+static void
+CheckLookup(MachOModule& module, const char* symbolName)
+{
+    uint64_t indexValue = 1;
+    bool indexFound = module.TryLookupSymbol(symbolName, &indexValue);
+    uint64_t linearValue = 1;
+    bool linearFound = LinearLookupSymbol(module, symbolName, &linearValue);
+    if (indexFound != linearFound || indexValue != linearValue)
+    {
+        printf("'%s': index %d %llx linear %d %llx\n", symbolName, indexFound, (unsigned long long)indexValue, linearFound, (unsigned long long)linearValue);
+        s_failures++;
+    }
+}
+
+//
+// ReadHeader with the header bytes already read (i.e. by TryRegisterModule): the load
+// commands are copied from them when they fit and read from the module otherwise.
+//
+static void
+CheckPrefetchedHeader(const std::vector<BYTE>& image)
+{
+    uint64_t value;
+    BYTE buildId[32];
+    ULONG buildIdSize = 0;
+
+    MachOReaderFromBuffer reader(image);
+    MachOModule module(reader, true, 0);
+    CHECK(module.ReadHeader(image.data(), LinkEditOffset));
+    CHECK(module.TryLookupSymbol("DotNetRuntimeInfo", &value));
+    CHECK(value == SymbolValueBase + (LocalCount + 5) * 16);
+    CHECK(reader.HeaderReads() == 0);
+
+    // GetBuildId reads the header again but uses the load commands already copied
+    CHECK(module.GetBuildId(buildId, sizeof(buildId), &buildIdSize));
+    CHECK(buildIdSize == 16 && buildId[0] == 0 && buildId[15] == 15);
+    CHECK(reader.HeaderReads() == 1);
+
+    // Only the header itself fits
+    MachOReaderFromBuffer partialReader(image);
+    MachOModule partial(partialReader, true, 0);
+    CHECK(partial.ReadHeader(image.data(), sizeof(mach_header_64) + sizeof(segment_command_64)));
+    CHECK(partial.TryLookupSymbol("DotNetRuntimeInfo", &value));
+    CHECK(value == SymbolValueBase + (LocalCount + 5) * 16);
+    CHECK(partialReader.HeaderReads() == 1);
+
+    std::vector<BYTE> invalidHeader(image.begin(), image.begin() + LinkEditOffset);
+    invalidHeader[0] = 0;
+    MachOModule invalid(reader, true, 0);
+    CHECK(!invalid.ReadHeader(invalidHeader.data(), invalidHeader.size()));
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::vector<BYTE> image;
+    std::vector<std::string> names;
+    CreateSampleModule(image, names);
+
+    MachOReaderFromBuffer reader(image);
+    MachOModule module(reader, true, 0);
+    CHECK(module.ReadHeader());
+
+    // Every symbol in the module, with and without the leading underscore
+    for (const std::string& name : names)
+    {
+        CheckLookup(module, name.c_str());
+        if (name[0] == '_')
+        {
+            CheckLookup(module, name.c_str() + 1);
+        }
+    }
+
+    // Names that aren't in the module
+    const char* missing[] = { "", "missing", "ext_", "ext_7000", "local_0", "dup_50", "_noscore_11", "DotNetRuntimeInf", "DotNetRuntimeInfoX" };
+    for (const char* name : missing)
+    {
+        CheckLookup(module, name);
+    }
+
+    uint64_t value;
+    CHECK(module.TryLookupSymbol("DotNetRuntimeInfo", &value));
+    CHECK(value == SymbolValueBase + (LocalCount + 5) * 16);
+
+    // The external symbol wins over the local with the same name
+    CHECK(module.TryLookupSymbol("ext_7", &value));
+    CHECK(value == SymbolValueBase + (LocalCount + 7) * 16);
+
+    // The first of the duplicate local symbols
+    CHECK(module.TryLookupSymbol("dup_13", &value));
+    CHECK(value == SymbolValueBase + 13 * 16);
+
+    CHECK(!module.TryLookupSymbol("missing", &value));
+    CHECK(value == 0);
+
+    CheckPrefetchedHeader(image);
+
+    return TestResult();
+}
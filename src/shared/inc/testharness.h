@@ -0,0 +1,32 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+//
+// Minimal harness of the native unit tests (PAL and dbgutil tests): CHECK reports and counts
+// the failed conditions and TestResult prints the outcome and returns the exit code of main.
+//
+
+#pragma once
+
+#include <stdio.h>
+
+static int s_failures = 0;
+
+#define CHECK(condition) \
+    if (!(condition)) \
+    { \
+        printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+        s_failures++; \
+    }
+
+static int
+TestResult()
+{
+    if (s_failures != 0)
+    {
+        printf("FAILED: %d checks\n", s_failures);
+        return 1;
+    }
+    printf("PASSED\n");
+    return 0;
+}
@@ -126,5 +126,11 @@ namespace CorUnix
     extern IPalObject *g_pobjProcess;
 }
 
+//
+// Builds the EnumProcessModules list from the contents of a /proc/<pid>/maps file
+//
+CorUnix::ProcessModules *CreateProcessModulesFromMaps(LPCSTR maps, SIZE_T size, LPDWORD lpCount);
+void DestroyProcessModules(CorUnix::ProcessModules *listHead);
+
 #endif // _PAL_PROCOBJ_HPP_
 
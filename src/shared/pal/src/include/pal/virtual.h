@@ -26,9 +26,6 @@ extern "C"
 
 typedef struct _CMI {
 
-    struct _CMI * pNext;        /* Link to the next entry. */
-    struct _CMI * pPrevious;    /* Link to the previous entry. */
-
     UINT_PTR startBoundary;     /* Starting location of the region. */
     SIZE_T   memSize;           /* Size of the entire region.. */
 
@@ -50,8 +50,13 @@ using namespace CorUnix;
 
 CRITICAL_SECTION virtual_critsec;
 
-// The first node in our list of allocated blocks.
-static PCMI pVirtualMemory;
+// The allocated blocks sorted by start address. The regions don't overlap so the
+// region containing an address is found with a binary search on the start address.
+static PCMI* pVirtualMemory;
+static SIZE_T nVirtualMemoryCount;
+static SIZE_T nVirtualMemoryCapacity;
+
+#define VIRTUAL_INITIAL_REGION_CAPACITY 64
 
 static size_t s_virtualPageSize = 0;
 
@@ -173,6 +178,8 @@ VIRTUALInitialize(bool initializeExecutableMemoryAllocator)
     InternalInitializeCriticalSection(&virtual_critsec);
 
     pVirtualMemory = NULL;
+    nVirtualMemoryCount = 0;
+    nVirtualMemoryCapacity = 0;
 
     if (initializeExecutableMemoryAllocator)
     {
@@ -191,23 +198,21 @@ VIRTUALInitialize(bool initializeExecutableMemoryAllocator)
 extern "C"
 void VIRTUALCleanup()
 {
-    PCMI pEntry;
-    PCMI pTempEntry;
     CPalThread * pthrCurrent = InternalGetCurrentThread();
 
     InternalEnterCriticalSection(pthrCurrent, &virtual_critsec);
 
     // Clean up the allocated memory.
-    pEntry = pVirtualMemory;
-    while ( pEntry )
+    for ( SIZE_T index = 0; index < nVirtualMemoryCount; index++ )
     {
         WARN( "The memory at %d was not freed through a call to VirtualFree.\n",
-              pEntry->startBoundary );
-        pTempEntry = pEntry;
-        pEntry = pEntry->pNext;
-        free(pTempEntry );
+              pVirtualMemory[index]->startBoundary );
+        free( pVirtualMemory[index] );
     }
+    free( pVirtualMemory );
     pVirtualMemory = NULL;
+    nVirtualMemoryCount = 0;
+    nVirtualMemoryCapacity = 0;
 
     InternalLeaveCriticalSection(pthrCurrent, &virtual_critsec);
 
@@ -235,6 +240,36 @@ static BOOL VIRTUALContainsInvalidProtectionFlags( IN DWORD flProtect )
 }
 
 
+/****
+ *
+ * VIRTUALFindInsertIndex( )
+ *
+ *          IN UINT_PTR address - The address to look for.
+ *
+ *          Returns the index of the first entry starting above the address
+ *          (nVirtualMemoryCount if there is none).
+ *          NOTE: The caller must own the critical section.
+ */
+static SIZE_T VIRTUALFindInsertIndex( IN UINT_PTR address )
+{
+    SIZE_T low = 0;
+    SIZE_T high = nVirtualMemoryCount;
+
+    while ( low < high )
+    {
+        SIZE_T middle = low + (high - low) / 2;
+        if ( pVirtualMemory[middle]->startBoundary > address )
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
 /****
  *
  * VIRTUALFindRegionInformation( )
@@ -246,25 +281,19 @@ static BOOL VIRTUALContainsInvalidProtectionFlags( IN DWORD flProtect )
 static PCMI VIRTUALFindRegionInformation( IN UINT_PTR address )
 {
     PCMI pEntry = NULL;
+    SIZE_T index;
 
     TRACE( "VIRTUALFindRegionInformation( %#x )\n", address );
 
-    pEntry = pVirtualMemory;
-
-    while( pEntry )
+    /* The only region that can contain the address is the last one starting at or below it. */
+    index = VIRTUALFindInsertIndex( address );
+    if ( index > 0 )
     {
-        if ( pEntry->startBoundary > address )
+        pEntry = pVirtualMemory[index - 1];
+        if ( pEntry->startBoundary + pEntry->memSize <= address )
         {
-            /* Gone past the possible location in the list. */
             pEntry = NULL;
-            break;
-        }
-        if ( pEntry->startBoundary + pEntry->memSize > address )
-        {
-            break;
         }
-
-        pEntry = pEntry->pNext;
     }
     return pEntry;
 }
@@ -274,13 +303,14 @@ Function :
 
     VIRTUALReleaseMemory
 
-    Removes a PCMI entry from the list.
+    Removes a PCMI entry from the region array.
 
     Returns true on success. FALSE otherwise.
 --*/
 static BOOL VIRTUALReleaseMemory( PCMI pMemoryToBeReleased )
 {
     BOOL bRetVal = TRUE;
+    SIZE_T index;
 
     if ( !pMemoryToBeReleased )
     {
@@ -288,28 +318,27 @@ static BOOL VIRTUALReleaseMemory( PCMI pMemoryToBeReleased )
         return FALSE;
     }
 
-    if ( pMemoryToBeReleased == pVirtualMemory )
+    /* Entries starting at the same address are only possible for empty regions; look back through them. */
+    index = VIRTUALFindInsertIndex( pMemoryToBeReleased->startBoundary );
+    while ( index > 0 && pVirtualMemory[index - 1] != pMemoryToBeReleased )
     {
-        /* This is either the first entry, or the only entry. */
-        pVirtualMemory = pMemoryToBeReleased->pNext;
-        if ( pMemoryToBeReleased->pNext )
+        if ( pVirtualMemory[index - 1]->startBoundary != pMemoryToBeReleased->startBoundary )
         {
-            pMemoryToBeReleased->pNext->pPrevious = NULL;
+            index = 0;
+            break;
         }
+        index--;
     }
-    else /* Could be anywhere in the list. */
+    if ( index == 0 )
     {
-        /* Delete the entry from the linked list. */
-        if ( pMemoryToBeReleased->pPrevious )
-        {
-            pMemoryToBeReleased->pPrevious->pNext = pMemoryToBeReleased->pNext;
-        }
-
-        if ( pMemoryToBeReleased->pNext )
-        {
-            pMemoryToBeReleased->pNext->pPrevious = pMemoryToBeReleased->pPrevious;
-        }
+        ASSERT( "The entry isn't in the region array.\n" );
+        return FALSE;
     }
+    index--;
+
+    memmove( &pVirtualMemory[index], &pVirtualMemory[index + 1],
+             (nVirtualMemoryCount - index - 1) * sizeof(PCMI) );
+    nVirtualMemoryCount--;
 
     free( pMemoryToBeReleased );
     pMemoryToBeReleased = NULL;
@@ -318,7 +347,7 @@ static BOOL VIRTUALReleaseMemory( PCMI pMemoryToBeReleased )
 }
 
 /***
- *  Displays the linked list.
+ *  Displays the region array.
  *
  */
 #if defined _DEBUG
@@ -329,26 +358,19 @@ static void VIRTUALDisplayList( void  )
 
     PCMI p;
     SIZE_T count;
-    SIZE_T index;
     CPalThread * pthrCurrent = InternalGetCurrentThread();
 
     InternalEnterCriticalSection(pthrCurrent, &virtual_critsec);
 
-    p = pVirtualMemory;
-    count = 0;
-    while ( p ) {
+    for ( count = 0; count < nVirtualMemoryCount; count++ ) {
 
+        p = pVirtualMemory[count];
         DBGOUT( "Entry %d : \n", count );
         DBGOUT( "\t startBoundary %#x \n", p->startBoundary );
         DBGOUT( "\t memSize %d \n", p->memSize );
 
         DBGOUT( "\t accessProtection %d \n", p->accessProtection );
         DBGOUT( "\t allocationType %d \n", p->allocationType );
-        DBGOUT( "\t pNext %p \n", p->pNext );
-        DBGOUT( "\t pLast %p \n", p->pPrevious );
-
-        count++;
-        p = p->pNext;
     }
 
     InternalLeaveCriticalSection(pthrCurrent, &virtual_critsec);
@@ -356,23 +378,25 @@ static void VIRTUALDisplayList( void  )
 #endif
 
 #ifdef DEBUG
-void VerifyRightEntry(PCMI pEntry)
+void VerifyRightEntry(SIZE_T index)
 {
-    volatile PCMI pRight = pEntry->pNext;
+    volatile PCMI pEntry = pVirtualMemory[index];
     SIZE_T endAddress;
-    if (pRight != nullptr)
+    if (index + 1 < nVirtualMemoryCount)
     {
+        volatile PCMI pRight = pVirtualMemory[index + 1];
         endAddress = ((SIZE_T)pEntry->startBoundary) + pEntry->memSize;
         _ASSERTE(endAddress <= (SIZE_T)pRight->startBoundary);
     }
 }
 
-void VerifyLeftEntry(PCMI pEntry)
+void VerifyLeftEntry(SIZE_T index)
 {
-    volatile PCMI pLeft = pEntry->pPrevious;
+    volatile PCMI pEntry = pVirtualMemory[index];
     SIZE_T endAddress;
-    if (pLeft != NULL)
+    if (index > 0)
     {
+        volatile PCMI pLeft = pVirtualMemory[index - 1];
         endAddress = ((SIZE_T)pLeft->startBoundary) + pLeft->memSize;
         _ASSERTE(endAddress <= (SIZE_T)pEntry->startBoundary);
     }
@@ -382,7 +406,7 @@ void VerifyLeftEntry(PCMI pEntry)
 /****
  *  VIRTUALStoreAllocationInfo()
  *
- *      Stores the allocation information in the linked list.
+ *      Stores the allocation information in the region array.
  *      NOTE: The caller must own the critical section.
  */
 static BOOL VIRTUALStoreAllocationInfo(
@@ -392,8 +416,7 @@ static BOOL VIRTUALStoreAllocationInfo(
             IN DWORD flProtection )     /* Protections flags on the memory. */
 {
     PCMI pNewEntry       = nullptr;
-    PCMI pMemInfo        = nullptr;
-    SIZE_T nBufferSize   = 0;
+    SIZE_T index         = 0;
 
     if (!IS_ALIGNED(memSize, GetVirtualPageSize()))
     {
@@ -407,49 +430,36 @@ static BOOL VIRTUALStoreAllocationInfo(
         return FALSE;
     }
 
-    pNewEntry->startBoundary    = startBoundary;
-    pNewEntry->memSize          = memSize;
-    pNewEntry->allocationType   = flAllocationType;
-    pNewEntry->accessProtection = flProtection;
-
-    pMemInfo = pVirtualMemory;
-
-    if (pMemInfo && pMemInfo->startBoundary < startBoundary)
+    if (nVirtualMemoryCount == nVirtualMemoryCapacity)
     {
-        /* Look for the correct insert point */
-        TRACE("Looking for the correct insert location.\n");
-        while (pMemInfo->pNext && (pMemInfo->pNext->startBoundary < startBoundary))
-        {
-            pMemInfo = pMemInfo->pNext;
-        }
-
-        pNewEntry->pNext = pMemInfo->pNext;
-        pNewEntry->pPrevious = pMemInfo;
-
-        if (pNewEntry->pNext)
+        SIZE_T newCapacity = nVirtualMemoryCapacity == 0 ? VIRTUAL_INITIAL_REGION_CAPACITY : nVirtualMemoryCapacity * 2;
+        PCMI* pNewArray = (PCMI*)realloc(pVirtualMemory, newCapacity * sizeof(PCMI));
+        if (pNewArray == nullptr)
         {
-            pNewEntry->pNext->pPrevious = pNewEntry;
+            ERROR( "Unable to grow the region array.\n");
+            free(pNewEntry);
+            return FALSE;
         }
-
-        pMemInfo->pNext = pNewEntry;
+        pVirtualMemory = pNewArray;
+        nVirtualMemoryCapacity = newCapacity;
     }
-    else
-    {
-        /* This is the first entry in the list. */
-        pNewEntry->pNext = pMemInfo;
-        pNewEntry->pPrevious = nullptr;
 
-        if (pNewEntry->pNext)
-        {
-            pNewEntry->pNext->pPrevious = pNewEntry;
-        }
+    pNewEntry->startBoundary    = startBoundary;
+    pNewEntry->memSize          = memSize;
+    pNewEntry->allocationType   = flAllocationType;
+    pNewEntry->accessProtection = flProtection;
 
-        pVirtualMemory = pNewEntry ;
-    }
+    /* Insert in front of the entries starting at or above the new region. */
+    index = startBoundary == 0 ? 0 : VIRTUALFindInsertIndex(startBoundary - 1);
+
+    memmove(&pVirtualMemory[index + 1], &pVirtualMemory[index],
+            (nVirtualMemoryCount - index) * sizeof(PCMI));
+    pVirtualMemory[index] = pNewEntry;
+    nVirtualMemoryCount++;
 
 #ifdef DEBUG
-    VerifyRightEntry(pNewEntry);
-    VerifyLeftEntry(pNewEntry);
+    VerifyRightEntry(index);
+    VerifyLeftEntry(index);
 #endif // DEBUG
 
     return TRUE;
@@ -77,6 +77,11 @@ SET_DEFAULT_DEBUG_CHANNEL(PROCESS); // some headers have code with asserts, so d
 #   error Unknown architecture
 #  endif
 # endif
+#include <sys/epoll.h>
+// pidfd_open has the same syscall number on all architectures
+# if !defined(__NR_pidfd_open)
+#  define __NR_pidfd_open 434
+# endif
 #endif
 
 #if HAVE_KQUEUE
@@ -100,6 +105,12 @@ extern "C"
 #define ENABLE_RUNTIME_EVENTS_OVER_PIPES
 #endif // __APPLE__
 
+#if defined(__linux__) || (HAVE_KQUEUE && !HAVE_BROKEN_FIFO_KEVENT)
+// One thread waits for the runtime startup events and target process exits of all the
+// PAL_RegisterForRuntimeStartup registrations (epoll and pidfd on Linux, kqueue otherwise).
+#define ENABLE_RUNTIME_STARTUP_MONITOR
+#endif
+
 #ifdef __NetBSD__
 #include <sys/cdefs.h>
 #include <sys/param.h>
@@ -1244,6 +1255,88 @@ static const char* RuntimeContinuePipeName = "co";
 #define PIPE_OPEN_RETRY_DELAY_NS 500000000 // 500 ms
 #endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES
 
+#ifdef ENABLE_RUNTIME_STARTUP_MONITOR
+
+class PAL_RuntimeStartupHelper;
+
+//
+// Waits for the runtime startup notifications of every registered process on a single
+// thread. Each registration watches for the target process exiting and, when the runtime
+// events are sent over pipes, for the startup pipe becoming readable. The registration is
+// removed and the helper notified (PAL_RuntimeStartupHelper::OnRuntimeStartupEvent) on
+// the first of those events. The thread is started by the first registration and exits
+// when the last one is removed, like the per-registration threads it replaces, so it
+// doesn't outlive the registrations of a module (i.e. dbgshim) that may be unloaded.
+//
+class RuntimeStartupMonitor
+{
+    enum WatchKind
+    {
+        Watch_ProcessExit = 0,
+        Watch_StartupPipe = 1,
+    };
+
+    struct Registration
+    {
+        UINT64 cookie;
+        PAL_RuntimeStartupHelper *helper;
+        DWORD processId;
+        int processFd;          // pidfd on Linux, -1 otherwise
+        int startupPipeFd;      // -1 if the startup pipe isn't watched
+    };
+
+    static pthread_mutex_t s_lock;
+    static RuntimeStartupMonitor *s_monitor;
+    static bool s_failed;
+
+    int m_pollFd;
+    int m_wakeFds[2];           // pipe that wakes up the thread to exit; its events use cookie 0
+    bool m_stopping;
+    UINT64 m_nextCookie;
+    std::vector<Registration> m_registrations;
+
+    static UINT64 MakeWatchData(UINT64 cookie, WatchKind kind)
+    {
+        return (cookie << 1) | kind;
+    }
+
+    bool Start();
+    void Close();
+    bool Watch(Registration &registration);
+    void Unwatch(const Registration &registration);
+    void RemoveRegistration(size_t index);
+    void Dispatch(UINT64 cookie, WatchKind kind);
+    void Fail();
+    void Run();
+
+    static DWORD MonitorThread(LPVOID p);
+
+public:
+    RuntimeStartupMonitor() :
+        m_pollFd(-1),
+        m_stopping(false),
+        m_nextCookie(0)
+    {
+        m_wakeFds[0] = -1;
+        m_wakeFds[1] = -1;
+    }
+
+    // Starts watching the process (and the startup pipe if not -1) for the helper. The
+    // registration cookie is stored in *cookie under the monitor lock. Returns false if
+    // the process can't be monitored or waiting for events failed before.
+    static bool Add(PAL_RuntimeStartupHelper *helper, DWORD processId, int startupPipeFd, UINT64 *cookie);
+
+    // Removes the registration if the monitor hasn't already dispatched it and clears the
+    // cookie. The helper isn't notified anymore after this returns.
+    static void Remove(UINT64 *cookie);
+};
+
+pthread_mutex_t RuntimeStartupMonitor::s_lock = PTHREAD_MUTEX_INITIALIZER;
+RuntimeStartupMonitor *RuntimeStartupMonitor::s_monitor = NULL;
+bool RuntimeStartupMonitor::s_failed = false;
+
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR
+
 class PAL_RuntimeStartupHelper
 {
     LONG m_ref;
@@ -1272,12 +1365,23 @@ class PAL_RuntimeStartupHelper
     char m_applicationGroupId[MAX_APPLICATION_GROUP_ID_LENGTH+1];
 #endif // __APPLE__
 
+#ifdef ENABLE_RUNTIME_STARTUP_MONITOR
+    // RuntimeStartupMonitor registration cookie or 0 if not registered
+    UINT64 m_monitorCookie;
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR
+
 #ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
     char m_startupPipeName[MAX_DEBUGGER_TRANSPORT_PIPE_NAME_LENGTH];
     char m_continuePipeName[MAX_DEBUGGER_TRANSPORT_PIPE_NAME_LENGTH];
     DWORD m_runtimeEventsThreadId;
     HANDLE m_runtimeEventsThreadHandle;
 
+    // The pipes opened when the monitor waits for the runtime events instead of the runtime
+    // events thread. -1 otherwise.
+    int m_startupPipeFd;
+    int m_continuePipeFd;
+    LONG m_continueSent;
+
     typedef enum
     {
         RuntimeEvent_Unknown = 0,
@@ -1579,6 +1683,41 @@ class PAL_RuntimeStartupHelper
         return DoNonBlockingPipeIO(fd, (void *)buf, count, timeout, WriteIOFunc, POLLOUT);
     }
 #endif // HAVE_KQUEUE && !HAVE_BROKEN_FIFO_KEVENT
+
+    void CloseRuntimeEventPipes()
+    {
+        CloseFd(m_startupPipeFd);
+        m_startupPipeFd = -1;
+        CloseFd(m_continuePipeFd);
+        m_continuePipeFd = -1;
+    }
+
+#ifdef ENABLE_RUNTIME_STARTUP_MONITOR
+    // Opens both pipes read/write so that neither open has to wait (or retry) for the runtime
+    // to connect. The runtime's blocking opens of the continue (read) and startup (write) pipes
+    // complete immediately and the startup pipe doesn't report EOF before the runtime opens it.
+    bool OpenRuntimeEventPipes()
+    {
+        int flags = O_RDWR | O_NONBLOCK;
+
+#if defined(FD_CLOEXEC)
+        flags |= O_CLOEXEC;
+#endif
+
+        while ((m_continuePipeFd = open(m_continuePipeName, flags)) == -1 && errno == EINTR);
+        if (m_continuePipeFd != -1)
+        {
+            while ((m_startupPipeFd = open(m_startupPipeName, flags)) == -1 && errno == EINTR);
+        }
+        if (m_continuePipeFd == -1 || m_startupPipeFd == -1)
+        {
+            TRACE("OpenRuntimeEventPipes: open failed: errno is %d (%s)\n", errno, strerror(errno));
+            CloseRuntimeEventPipes();
+            return false;
+        }
+        return true;
+    }
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR
 #endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES
 
 #ifdef __APPLE__
@@ -1605,9 +1744,15 @@ public:
         m_processId(dwProcessId),
         m_startupSem(SEM_FAILED),
         m_continueSem(SEM_FAILED)
+#ifdef ENABLE_RUNTIME_STARTUP_MONITOR
+        , m_monitorCookie(0)
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR
 #ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
         , m_runtimeEventsThreadId(0)
         , m_runtimeEventsThreadHandle(NULL)
+        , m_startupPipeFd(-1)
+        , m_continuePipeFd(-1)
+        , m_continueSent(0)
 #endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES
     {
     }
@@ -1632,6 +1777,7 @@ public:
         }
 
 #ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
+        CloseRuntimeEventPipes();
         unlink(m_startupPipeName);
         unlink(m_continuePipeName);
 
@@ -1695,7 +1841,9 @@ public:
         PAL_ERROR pe = NO_ERROR;
         BOOL ret;
         UnambiguousProcessDescriptor unambiguousProcessDescriptor;
+#ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
         SIZE_T osThreadId = 0;
+#endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES
 
 #ifdef __APPLE__
         if (lpApplicationGroupId != NULL)
@@ -1764,6 +1912,19 @@ public:
             goto exit;
         }
 
+#if defined(ENABLE_RUNTIME_EVENTS_OVER_PIPES) && defined(ENABLE_RUNTIME_STARTUP_MONITOR)
+        // Let the monitor thread wait for the started event (or the process exit) instead of
+        // the runtime events thread. The startup helper thread is created when it happens.
+        if (!IsCoreClrProcessReady() && OpenRuntimeEventPipes())
+        {
+            if (RuntimeStartupMonitor::Add(this, m_processId, m_startupPipeFd, &m_monitorCookie))
+            {
+                goto exit;
+            }
+            CloseRuntimeEventPipes();
+        }
+#endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES && ENABLE_RUNTIME_STARTUP_MONITOR
+
 #ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
         // Add a reference for the thread handler
         AddRef();
@@ -1788,9 +1949,28 @@ public:
         m_runtimeEventsThreadId = (DWORD)osThreadId;
 #endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES
 
+        pe = CreateStartupHelperThread(pThread);
+        if (NO_ERROR != pe)
+        {
+            goto exit;
+        }
+
+#if defined(ENABLE_RUNTIME_STARTUP_MONITOR) && !defined(ENABLE_RUNTIME_EVENTS_OVER_PIPES)
+        // Wake up the startup helper thread if the process exits before the runtime starts. The
+        // process just isn't watched if this fails.
+        RuntimeStartupMonitor::Add(this, m_processId, -1, &m_monitorCookie);
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR && !ENABLE_RUNTIME_EVENTS_OVER_PIPES
+    exit:
+        return pe;
+    }
+
+    PAL_ERROR CreateStartupHelperThread(CPalThread *pThread)
+    {
+        SIZE_T osThreadId = 0;
+
         // Add a reference for the thread handler
         AddRef();
-        pe = InternalCreateThread(
+        PAL_ERROR pe = InternalCreateThread(
             pThread,
             NULL,
             0,
@@ -1805,22 +1985,23 @@ public:
         {
             TRACE("InternalCreateThread failed %d\n", pe);
             Release();
-            goto exit;
+            return pe;
         }
         m_threadId = (DWORD)osThreadId;
-    exit:
-        return pe;
+        return NO_ERROR;
     }
 
     void Unregister()
     {
         m_canceled = true;
 
+#ifdef ENABLE_RUNTIME_STARTUP_MONITOR
+        // Keeps the monitor from starting the worker thread after this
+        RuntimeStartupMonitor::Remove(&m_monitorCookie);
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR
+
         // Tell the runtime to continue
-        if (sem_post(m_continueSem) != 0)
-        {
-            ASSERT("sem_post(continueSem) failed: errno is %d (%s)\n", errno, strerror(errno));
-        }
+        SignalContinue();
 
         // Tell the worker thread to continue
         if (sem_post(m_startupSem) != 0)
@@ -1828,15 +2009,16 @@ public:
             ASSERT("sem_post(startupSem) failed: errno is %d (%s)\n", errno, strerror(errno));
         }
 
-        // Don't need to wait for the worker threads if unregister called on it
-        if (m_threadId != (DWORD)THREADSilentGetCurrentThreadId())
+        // Don't need to wait for the worker threads if unregister called on it. There is no
+        // worker thread if the monitor was still waiting for the runtime.
+        if (m_threadHandle != NULL && m_threadId != (DWORD)THREADSilentGetCurrentThreadId())
         {
             // Wait for work thread to exit for 60 seconds
             WaitForSingleObject(m_threadHandle, 60 * 1000);
         }
 
 #ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
-        if (m_runtimeEventsThreadId != (DWORD)THREADSilentGetCurrentThreadId())
+        if (m_runtimeEventsThreadHandle != NULL && m_runtimeEventsThreadId != (DWORD)THREADSilentGetCurrentThreadId())
         {
             // Wait for runtime events thread to exit for 60 seconds
             WaitForSingleObject(m_runtimeEventsThreadHandle, 60 * 1000);
@@ -1918,17 +2100,84 @@ public:
 
     exit:
         // Wake up the runtime
+        SignalContinue();
+        if (listHead != NULL)
+        {
+            DestroyProcessModules(listHead);
+        }
+        return pe;
+    }
+
+    void SignalContinue()
+    {
         if (sem_post(m_continueSem) != 0)
         {
             ASSERT("sem_post(continueSem) failed: errno is %d (%s)\n", errno, strerror(errno));
         }
-        if (listHead != NULL)
+
+#ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
+        // Send the continue event here when there is no runtime events thread to do it
+        if (m_continuePipeFd != -1 && InterlockedExchange(&m_continueSent, 1) == 0)
         {
-            DestroyProcessModules(listHead);
+            unsigned char event = (unsigned char)RuntimeEvent_Continue;
+            ssize_t bytesWritten;
+            while ((bytesWritten = write(m_continuePipeFd, &event, sizeof(event))) == -1 && errno == EINTR);
+            if (bytesWritten != sizeof(event))
+            {
+                TRACE("SignalContinue: failed sending continue event: errno is %d (%s)\n", errno, strerror(errno));
+            }
         }
-        return pe;
+#endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES
     }
 
+#ifdef ENABLE_RUNTIME_STARTUP_MONITOR
+#ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
+    // Called by the monitor when the startup pipe is readable. Returns ERROR_IO_PENDING if
+    // there isn't anything to read yet.
+    PAL_ERROR ReadStartupEvent()
+    {
+        unsigned char event = (unsigned char)RuntimeEvent_Unknown;
+        ssize_t bytesRead;
+        while ((bytesRead = read(m_startupPipeFd, &event, sizeof(event))) == -1 && errno == EINTR);
+        if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return ERROR_IO_PENDING;
+        }
+        if (bytesRead == sizeof(event) && event == (unsigned char)RuntimeEvent_Started)
+        {
+            TRACE("ReadStartupEvent: received started event\n");
+            return NO_ERROR;
+        }
+        TRACE("ReadStartupEvent: received invalid event\n");
+        return ERROR_INVALID_PARAMETER;
+    }
+#endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES
+
+    // Called by the monitor thread (with the monitor lock held) when the runtime started or
+    // with ERROR_PROCESS_ABORTED when the process exited first.
+    void OnRuntimeStartupEvent(PAL_ERROR error)
+    {
+        TRACE("OnRuntimeStartupEvent: pid %d error %d\n", m_processId, error);
+
+        if (error != NO_ERROR)
+        {
+            m_error = error;
+        }
+
+        // Wake up the worker thread or create it if the monitor was waiting in its place
+        sem_post(m_startupSem);
+
+        if (m_threadHandle == NULL && !m_canceled)
+        {
+            if (CreateStartupHelperThread(InternalGetCurrentThread()) != NO_ERROR)
+            {
+                ERROR("OnRuntimeStartupEvent: failed to create the startup helper thread for pid %d\n", m_processId);
+                SignalContinue();
+            }
+        }
+    }
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR
+
 #ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
     void StartupHelperRuntimeEventsThread()
     {
@@ -2120,6 +2369,11 @@ public:
             }
         }
 
+#ifdef ENABLE_RUNTIME_STARTUP_MONITOR
+        // The process exit doesn't need to be watched anymore
+        RuntimeStartupMonitor::Remove(&m_monitorCookie);
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR
+
         // Invoke the callback on errors
         if (pe != NO_ERROR && !m_canceled)
         {
@@ -2158,6 +2412,409 @@ StartupHelperThread(LPVOID p)
     return 0;
 }
 
+#ifdef ENABLE_RUNTIME_STARTUP_MONITOR
+
+bool
+RuntimeStartupMonitor::Add(PAL_RuntimeStartupHelper *helper, DWORD processId, int startupPipeFd, UINT64 *cookie)
+{
+    bool result = false;
+
+    pthread_mutex_lock(&s_lock);
+
+    if (s_monitor == NULL && !s_failed)
+    {
+        RuntimeStartupMonitor *monitor = InternalNew<RuntimeStartupMonitor>();
+        if (monitor != NULL && !monitor->Start())
+        {
+            InternalDelete(monitor);
+            monitor = NULL;
+        }
+        s_monitor = monitor;
+    }
+
+    if (s_monitor != NULL)
+    {
+        Registration registration;
+        registration.cookie = ++s_monitor->m_nextCookie;
+        registration.helper = helper;
+        registration.processId = processId;
+        registration.processFd = -1;
+        registration.startupPipeFd = startupPipeFd;
+
+        if (s_monitor->Watch(registration))
+        {
+            // The registration keeps a reference until it is removed or dispatched
+            helper->AddRef();
+            s_monitor->m_registrations.push_back(registration);
+            *cookie = registration.cookie;
+            result = true;
+        }
+        else if (s_monitor->m_registrations.empty())
+        {
+            // Don't leave the thread waiting without any registrations
+            s_monitor->RemoveRegistration((size_t)-1);
+        }
+    }
+
+    pthread_mutex_unlock(&s_lock);
+    return result;
+}
+
+void
+RuntimeStartupMonitor::Remove(UINT64 *cookie)
+{
+    PAL_RuntimeStartupHelper *helper = NULL;
+
+    pthread_mutex_lock(&s_lock);
+
+    if (*cookie != 0 && s_monitor != NULL)
+    {
+        std::vector<Registration> &registrations = s_monitor->m_registrations;
+        for (size_t i = 0; i < registrations.size(); i++)
+        {
+            if (registrations[i].cookie == *cookie)
+            {
+                helper = registrations[i].helper;
+                s_monitor->RemoveRegistration(i);
+                break;
+            }
+        }
+    }
+    *cookie = 0;
+
+    pthread_mutex_unlock(&s_lock);
+
+    if (helper != NULL)
+    {
+        helper->Release();
+    }
+}
+
+bool
+RuntimeStartupMonitor::Start()
+{
+#ifdef __linux__
+    m_pollFd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    m_pollFd = kqueue();
+#endif
+    if (m_pollFd == -1)
+    {
+        TRACE("RuntimeStartupMonitor: creating the poll fd failed: errno is %d (%s)\n", errno, strerror(errno));
+        return false;
+    }
+
+    if (pipe(m_wakeFds) == -1)
+    {
+        TRACE("RuntimeStartupMonitor: creating the wake pipe failed: errno is %d (%s)\n", errno, strerror(errno));
+        m_wakeFds[0] = m_wakeFds[1] = -1;
+        Close();
+        return false;
+    }
+    fcntl(m_wakeFds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(m_wakeFds[1], F_SETFD, FD_CLOEXEC);
+
+#ifdef __linux__
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = MakeWatchData(0, Watch_ProcessExit);
+    if (epoll_ctl(m_pollFd, EPOLL_CTL_ADD, m_wakeFds[0], &event) == -1)
+#else
+    struct kevent change;
+    EV_SET(&change, m_wakeFds[0], EVFILT_READ, EV_ADD, 0, 0, (void *)(uintptr_t)MakeWatchData(0, Watch_ProcessExit));
+    if (kevent(m_pollFd, &change, 1, NULL, 0, NULL) == -1)
+#endif
+    {
+        TRACE("RuntimeStartupMonitor: watching the wake pipe failed: errno is %d (%s)\n", errno, strerror(errno));
+        Close();
+        return false;
+    }
+
+    HANDLE threadHandle = NULL;
+    PAL_ERROR pe = InternalCreateThread(
+        InternalGetCurrentThread(),
+        NULL,
+        0,
+        MonitorThread,
+        this,
+        0,
+        UserCreatedThread,
+        NULL,
+        &threadHandle);
+
+    if (NO_ERROR != pe)
+    {
+        TRACE("RuntimeStartupMonitor: InternalCreateThread failed %d\n", pe);
+        Close();
+        return false;
+    }
+
+    // The thread is never waited on
+    CloseHandle(threadHandle);
+    return true;
+}
+
+void
+RuntimeStartupMonitor::Close()
+{
+    for (int fd : { m_pollFd, m_wakeFds[0], m_wakeFds[1] })
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+    m_pollFd = -1;
+    m_wakeFds[0] = m_wakeFds[1] = -1;
+}
+
+bool
+RuntimeStartupMonitor::Watch(Registration &registration)
+{
+#ifdef __linux__
+    registration.processFd = (int)syscall(__NR_pidfd_open, registration.processId, 0);
+    if (registration.processFd == -1)
+    {
+        TRACE("RuntimeStartupMonitor: pidfd_open(%d) failed: errno is %d (%s)\n", registration.processId, errno, strerror(errno));
+        return false;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = MakeWatchData(registration.cookie, Watch_ProcessExit);
+    if (epoll_ctl(m_pollFd, EPOLL_CTL_ADD, registration.processFd, &event) == -1)
+    {
+        TRACE("RuntimeStartupMonitor: epoll_ctl(pidfd) failed: errno is %d (%s)\n", errno, strerror(errno));
+        close(registration.processFd);
+        registration.processFd = -1;
+        return false;
+    }
+
+    if (registration.startupPipeFd != -1)
+    {
+        event.events = EPOLLIN;
+        event.data.u64 = MakeWatchData(registration.cookie, Watch_StartupPipe);
+        if (epoll_ctl(m_pollFd, EPOLL_CTL_ADD, registration.startupPipeFd, &event) == -1)
+        {
+            TRACE("RuntimeStartupMonitor: epoll_ctl(startup pipe) failed: errno is %d (%s)\n", errno, strerror(errno));
+            Unwatch(registration);
+            return false;
+        }
+    }
+#else
+    // Each change is applied separately so a failure can't leave the other one half done
+    struct kevent change;
+    EV_SET(&change, registration.processId, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0,
+        (void *)(uintptr_t)MakeWatchData(registration.cookie, Watch_ProcessExit));
+    if (kevent(m_pollFd, &change, 1, NULL, 0, NULL) == -1)
+    {
+        TRACE("RuntimeStartupMonitor: kevent(EVFILT_PROC %d) failed: errno is %d (%s)\n", registration.processId, errno, strerror(errno));
+        return false;
+    }
+
+    if (registration.startupPipeFd != -1)
+    {
+        EV_SET(&change, registration.startupPipeFd, EVFILT_READ, EV_ADD, 0, 0,
+            (void *)(uintptr_t)MakeWatchData(registration.cookie, Watch_StartupPipe));
+        if (kevent(m_pollFd, &change, 1, NULL, 0, NULL) == -1)
+        {
+            TRACE("RuntimeStartupMonitor: kevent(EVFILT_READ) failed: errno is %d (%s)\n", errno, strerror(errno));
+            Unwatch(registration);
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+void
+RuntimeStartupMonitor::Unwatch(const Registration &registration)
+{
+    // Errors are ignored; the process watch is already gone if the process exited
+#ifdef __linux__
+    if (registration.startupPipeFd != -1)
+    {
+        epoll_ctl(m_pollFd, EPOLL_CTL_DEL, registration.startupPipeFd, NULL);
+    }
+    if (registration.processFd != -1)
+    {
+        epoll_ctl(m_pollFd, EPOLL_CTL_DEL, registration.processFd, NULL);
+        close(registration.processFd);
+    }
+#else
+    struct kevent change;
+    if (registration.startupPipeFd != -1)
+    {
+        EV_SET(&change, registration.startupPipeFd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+        kevent(m_pollFd, &change, 1, NULL, 0, NULL);
+    }
+    EV_SET(&change, registration.processId, EVFILT_PROC, EV_DELETE, 0, 0, NULL);
+    kevent(m_pollFd, &change, 1, NULL, 0, NULL);
+#endif
+}
+
+// Called with the monitor lock held. Stops watching and removes the registration at the
+// index (none if -1). When no registrations are left the monitor is detached (the next
+// Add starts a new one) and its thread woken up to exit.
+void
+RuntimeStartupMonitor::RemoveRegistration(size_t index)
+{
+    if (index != (size_t)-1)
+    {
+        Unwatch(m_registrations[index]);
+        m_registrations.erase(m_registrations.begin() + index);
+    }
+    if (m_registrations.empty() && !m_stopping)
+    {
+        m_stopping = true;
+        if (s_monitor == this)
+        {
+            s_monitor = NULL;
+        }
+        char wake = 0;
+        while (write(m_wakeFds[1], &wake, 1) == -1 && errno == EINTR);
+    }
+}
+
+void
+RuntimeStartupMonitor::Dispatch(UINT64 cookie, WatchKind kind)
+{
+    PAL_RuntimeStartupHelper *helper = NULL;
+
+    // The helper is notified with the lock held so that Remove (and so Unregister) doesn't
+    // return while the notification is still in progress.
+    pthread_mutex_lock(&s_lock);
+
+    for (size_t i = 0; i < m_registrations.size(); i++)
+    {
+        if (m_registrations[i].cookie != cookie)
+        {
+            continue;
+        }
+        PAL_ERROR error = ERROR_PROCESS_ABORTED;
+#ifdef ENABLE_RUNTIME_EVENTS_OVER_PIPES
+        if (kind == Watch_StartupPipe)
+        {
+            error = m_registrations[i].helper->ReadStartupEvent();
+            if (error == ERROR_IO_PENDING)
+            {
+                break;
+            }
+        }
+#endif // ENABLE_RUNTIME_EVENTS_OVER_PIPES
+        helper = m_registrations[i].helper;
+        RemoveRegistration(i);
+
+        helper->OnRuntimeStartupEvent(error);
+        break;
+    }
+
+    pthread_mutex_unlock(&s_lock);
+
+    if (helper != NULL)
+    {
+        helper->Release();
+    }
+}
+
+// Called when waiting for events fails. The registrations the monitor waits for in place
+// of a startup helper thread (the startup pipe ones) are notified with the error so their
+// callbacks are invoked; the others just aren't watched anymore, as if Add had failed. The
+// later registrations use their own threads.
+void
+RuntimeStartupMonitor::Fail()
+{
+    std::vector<PAL_RuntimeStartupHelper *> helpers;
+
+    pthread_mutex_lock(&s_lock);
+
+    s_failed = true;
+    while (!m_registrations.empty())
+    {
+        Registration registration = m_registrations.back();
+        RemoveRegistration(m_registrations.size() - 1);
+        if (registration.startupPipeFd != -1)
+        {
+            registration.helper->OnRuntimeStartupEvent(ERROR_INTERNAL_ERROR);
+        }
+        helpers.push_back(registration.helper);
+    }
+    RemoveRegistration((size_t)-1);
+
+    pthread_mutex_unlock(&s_lock);
+
+    for (PAL_RuntimeStartupHelper *helper : helpers)
+    {
+        helper->Release();
+    }
+}
+
+void
+RuntimeStartupMonitor::Run()
+{
+    const int MaxEvents = 16;
+
+    while (true)
+    {
+        pthread_mutex_lock(&s_lock);
+        bool stopping = m_stopping;
+        pthread_mutex_unlock(&s_lock);
+        if (stopping)
+        {
+            break;
+        }
+
+#ifdef __linux__
+        struct epoll_event events[MaxEvents];
+        int count = epoll_wait(m_pollFd, events, MaxEvents, -1);
+#else
+        struct kevent events[MaxEvents];
+        int count = kevent(m_pollFd, NULL, 0, events, MaxEvents, NULL);
+#endif
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            ERROR("RuntimeStartupMonitor: waiting for events failed: errno is %d (%s)\n", errno, strerror(errno));
+            Fail();
+            break;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+#ifdef __linux__
+            UINT64 data = events[i].data.u64;
+#else
+            UINT64 data = (UINT64)(uintptr_t)events[i].udata;
+#endif
+            // Cookie 0 is the wake pipe; the stopping flag is checked above
+            if ((data >> 1) != 0)
+            {
+                Dispatch(data >> 1, (WatchKind)(data & 1));
+            }
+        }
+    }
+}
+
+DWORD
+RuntimeStartupMonitor::MonitorThread(LPVOID p)
+{
+    TRACE("RuntimeStartupMonitor thread starting\n");
+
+    // The monitor is already detached (s_monitor) when Run returns so nothing else uses it
+    RuntimeStartupMonitor *monitor = (RuntimeStartupMonitor *)p;
+    monitor->Run();
+    monitor->Close();
+    InternalDelete(monitor);
+
+    TRACE("RuntimeStartupMonitor thread finished\n");
+    return 0;
+}
+
+#endif // ENABLE_RUNTIME_STARTUP_MONITOR
+
 /*++
     PAL_RegisterForRuntimeStartup
 
@@ -2855,6 +3512,335 @@ exit:
     return listHead;
 }
 
+#if !defined(__APPLE__) && HAVE_PROCFS_MAPS
+
+struct MapsLine
+{
+    SIZE_T startAddress;
+    SIZE_T offset;
+    UINT64 inode;
+    const char *name;
+    size_t nameLength;
+};
+
+struct MapsModule
+{
+    const char *name;
+    size_t nameLength;
+    SIZE_T baseAddress;
+    SIZE_T minimumAddress;
+};
+
+/*++
+Function:
+  ReadProcMapsFile
+
+Abstract
+  Reads all of a /proc/<pid>/maps file into a malloc'ed buffer. procfs doesn't report
+  the file size so the buffer is grown until the end of the file is reached.
+
+Return
+  The buffer (the caller frees it) and its size in *pSize or NULL on failure
+--*/
+static
+char *
+ReadProcMapsFile(
+    LPCSTR fileName,
+    size_t *pSize)
+{
+    int fd;
+    while ((fd = open(fileName, O_RDONLY | O_CLOEXEC)) == -1 && errno == EINTR);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+
+    size_t capacity = 256 * 1024;
+    size_t size = 0;
+    char *buffer = (char *)malloc(capacity);
+    while (buffer != NULL)
+    {
+        if (size == capacity)
+        {
+            char *newBuffer = (char *)realloc(buffer, capacity * 2);
+            if (newBuffer == NULL)
+            {
+                free(buffer);
+                buffer = NULL;
+                break;
+            }
+            buffer = newBuffer;
+            capacity *= 2;
+        }
+        ssize_t bytesRead = read(fd, buffer + size, capacity - size);
+        if (bytesRead == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            free(buffer);
+            buffer = NULL;
+            break;
+        }
+        if (bytesRead == 0)
+        {
+            break;
+        }
+        size += bytesRead;
+    }
+
+    close(fd);
+    *pSize = size;
+    return buffer;
+}
+
+static
+const char *
+SkipMapsSpaces(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+    {
+        p++;
+    }
+    return p;
+}
+
+// Parses a hex or decimal number. Returns the character after it or NULL if there are no digits.
+static
+const char *
+ParseMapsNumber(const char *p, const char *end, bool hex, UINT64 *value)
+{
+    const char *start = p;
+    UINT64 result = 0;
+    for (; p < end; p++)
+    {
+        char c = *p;
+        UINT64 digit;
+        if (c >= '0' && c <= '9')
+        {
+            digit = c - '0';
+        }
+        else if (hex && c >= 'a' && c <= 'f')
+        {
+            digit = c - 'a' + 10;
+        }
+        else if (hex && c >= 'A' && c <= 'F')
+        {
+            digit = c - 'A' + 10;
+        }
+        else
+        {
+            break;
+        }
+        result = (result * (hex ? 16 : 10)) + digit;
+    }
+    *value = result;
+    return p == start ? NULL : p;
+}
+
+/*++
+Function:
+  ParseMapsLine
+
+Abstract
+  Parses one /proc/<pid>/maps line (without the newline):
+
+  35b1800000-35b1820000 r-xp 00000000 08:02 135522  /usr/lib64/ld-2.15.so
+
+Return
+  false if the line is malformed or doesn't have a path name
+--*/
+static
+bool
+ParseMapsLine(const char *p, const char *end, MapsLine *line)
+{
+    UINT64 startAddress, endAddress, offset, device, inode;
+
+    if ((p = ParseMapsNumber(p, end, true, &startAddress)) == NULL || p == end || *p++ != '-')
+    {
+        return false;
+    }
+    if ((p = ParseMapsNumber(p, end, true, &endAddress)) == NULL)
+    {
+        return false;
+    }
+
+    // Skip the permissions
+    p = SkipMapsSpaces(p, end);
+    while (p < end && *p != ' ' && *p != '\t')
+    {
+        p++;
+    }
+
+    if ((p = ParseMapsNumber(SkipMapsSpaces(p, end), end, true, &offset)) == NULL)
+    {
+        return false;
+    }
+    if ((p = ParseMapsNumber(SkipMapsSpaces(p, end), end, true, &device)) == NULL || p == end || *p++ != ':')
+    {
+        return false;
+    }
+    if ((p = ParseMapsNumber(p, end, true, &device)) == NULL)
+    {
+        return false;
+    }
+    if ((p = ParseMapsNumber(SkipMapsSpaces(p, end), end, false, &inode)) == NULL)
+    {
+        return false;
+    }
+
+    p = SkipMapsSpaces(p, end);
+    if (p == end || (end - p) >= PATH_MAX)
+    {
+        return false;
+    }
+
+    line->startAddress = (SIZE_T)startAddress;
+    line->offset = (SIZE_T)offset;
+    line->inode = inode;
+    line->name = p;
+    line->nameLength = end - p;
+    return true;
+}
+
+// FNV-1a
+static
+size_t
+HashMapsModuleName(const char *name, size_t length)
+{
+    UINT32 hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/*++
+Function:
+  CreateProcessModulesFromMaps
+
+Abstract
+  Builds the module list from the contents of a /proc/<pid>/maps file. Only file
+  mappings (inode != 0) are modules; the base address is the start of the mapping
+  at file offset 0 and the minimum address the lowest mapping of the file.
+
+Return
+  ProcessModules * list in the reverse order the modules are first mapped
+--*/
+ProcessModules *
+CreateProcessModulesFromMaps(
+    IN LPCSTR maps,
+    IN SIZE_T size,
+    OUT LPDWORD lpCount)
+{
+    ProcessModules *listHead = NULL;
+    int count = 0;
+    _ASSERTE(lpCount != NULL);
+
+    // The module names point into the maps buffer until the list is built. The
+    // table holds the indexes into the modules array hashed by name.
+    std::vector<MapsModule> modules;
+    std::vector<int> table(64, -1);
+    bool failed = false;
+
+    const char *current = maps;
+    const char *mapsEnd = maps + size;
+    while (current < mapsEnd)
+    {
+        const char *lineEnd = (const char *)memchr(current, '\n', mapsEnd - current);
+        if (lineEnd == NULL)
+        {
+            lineEnd = mapsEnd;
+        }
+        MapsLine mapsLine;
+        if (ParseMapsLine(current, lineEnd, &mapsLine) && mapsLine.inode != 0)
+        {
+            size_t mask = table.size() - 1;
+            size_t slot = HashMapsModuleName(mapsLine.name, mapsLine.nameLength) & mask;
+            int index;
+            while ((index = table[slot]) != -1)
+            {
+                const MapsModule &module = modules[index];
+                if (module.nameLength == mapsLine.nameLength && memcmp(module.name, mapsLine.name, mapsLine.nameLength) == 0)
+                {
+                    break;
+                }
+                slot = (slot + 1) & mask;
+            }
+
+            if (index != -1)
+            {
+                MapsModule &module = modules[index];
+                if (module.baseAddress == 0 && mapsLine.offset == 0)
+                {
+                    module.baseAddress = mapsLine.startAddress;
+                }
+                module.minimumAddress = std::min(mapsLine.startAddress, module.minimumAddress);
+            }
+            else
+            {
+                MapsModule module;
+                module.name = mapsLine.name;
+                module.nameLength = mapsLine.nameLength;
+                module.baseAddress = mapsLine.offset == 0 ? mapsLine.startAddress : 0;
+                module.minimumAddress = mapsLine.startAddress;
+                table[slot] = (int)modules.size();
+                modules.push_back(module);
+
+                // Keep the table at most half full
+                if (modules.size() * 2 > table.size())
+                {
+                    table.assign(table.size() * 2, -1);
+                    mask = table.size() - 1;
+                    for (size_t i = 0; i < modules.size(); i++)
+                    {
+                        slot = HashMapsModuleName(modules[i].name, modules[i].nameLength) & mask;
+                        while (table[slot] != -1)
+                        {
+                            slot = (slot + 1) & mask;
+                        }
+                        table[slot] = (int)i;
+                    }
+                }
+            }
+        }
+        current = lineEnd + 1;
+    }
+
+    // Build the list in the same (reverse) order as the modules were first mapped
+    for (size_t i = 0; i < modules.size(); i++)
+    {
+        const MapsModule &module = modules[i];
+        ProcessModules *entry = (ProcessModules *)malloc(sizeof(ProcessModules) + module.nameLength + 1);
+        if (entry == NULL)
+        {
+            failed = true;
+            break;
+        }
+        memcpy(entry->_name, module.name, module.nameLength);
+        entry->_name[module.nameLength] = '\0';
+        entry->_baseAddress = (PVOID)module.baseAddress;
+        entry->_minimumAddress = (PVOID)module.minimumAddress;
+        entry->_next = listHead;
+        listHead = entry;
+        count++;
+    }
+
+    if (failed)
+    {
+        DestroyProcessModules(listHead);
+        listHead = NULL;
+        count = 0;
+    }
+
+    *lpCount = count;
+    return listHead;
+}
+
+#endif // !__APPLE__ && HAVE_PROCFS_MAPS
+
 /*++
 Function:
   CreateProcessModules
@@ -2988,79 +3974,20 @@ CreateProcessModules(
 
     // Making something like: /proc/123/maps
     char mapFileName[100];
-    char *line = NULL;
-    size_t lineLen = 0;
-    int count = 0;
-    ssize_t read;
+    size_t size = 0;
 
     INDEBUG(int chars = )
     snprintf(mapFileName, sizeof(mapFileName), "/proc/%d/maps", dwProcessId);
     _ASSERTE(chars > 0 && chars <= (int)sizeof(mapFileName));
 
-    FILE *mapsFile = fopen(mapFileName, "r");
-    if (mapsFile == NULL)
+    // Read the whole file at once; processes can have tens of thousands of mappings
+    char *maps = ReadProcMapsFile(mapFileName, &size);
+    if (maps != NULL)
     {
-        goto exit;
+        listHead = CreateProcessModulesFromMaps(maps, size, lpCount);
+        free(maps);
     }
 
-    // Reading maps file line by line
-    while ((read = getline(&line, &lineLen, mapsFile)) != -1)
-    {
-        void *startAddress, *endAddress, *offset;
-        int devHi, devLo, inode;
-        char moduleName[PATH_MAX];
-
-        if (sscanf_s(line, "%p-%p %*[-rwxsp] %p %x:%x %d %[^\n]\n", &startAddress, &endAddress, &offset, &devHi, &devLo, &inode, moduleName, ARRAY_SIZE(moduleName)) == 7)
-        {
-            if (inode != 0)
-            {
-                bool dup = false;
-                for (ProcessModules *entry = listHead; entry != NULL; entry = entry->GetNext())
-                {
-                    if (strcmp(moduleName, entry->GetName()) == 0)
-                    {
-                        if (entry->_baseAddress == 0 && offset == 0)
-                        {
-                            entry->_baseAddress = startAddress;
-                        }
-                        entry->_minimumAddress = std::min(startAddress, entry->_minimumAddress);
-                        dup = true;
-                        break;
-                    }
-                }
-
-                if (!dup)
-                {
-                    int cbModuleName = strlen(moduleName) + 1;
-                    ProcessModules *entry = (ProcessModules *)malloc(sizeof(ProcessModules) + cbModuleName);
-                    if (entry == NULL)
-                    {
-                        DestroyProcessModules(listHead);
-                        listHead = NULL;
-                        count = 0;
-                        break;
-                    }
-                    strcpy_s(entry->_name, cbModuleName, moduleName);
-                    entry->_baseAddress = 0;
-                    entry->_minimumAddress = startAddress;
-                    if (offset == 0)
-                    {
-                        entry->_baseAddress = startAddress;
-                    }
-                    entry->_next = listHead;
-                    listHead = entry;
-                    count++;
-                }
-            }
-        }
-    }
-
-    *lpCount = count;
-
-    free(line); // We didn't allocate line, but as per contract of getline we should free it
-    fclose(mapsFile);
-exit:
-
 #else
     _ASSERTE(!"Not implemented on this platform");
 #endif
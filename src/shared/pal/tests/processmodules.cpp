@@ -0,0 +1,226 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+/*++
+
+Module Name:
+
+    tests/processmodules.cpp
+
+Abstract:
+
+    Tests the /proc/<pid>/maps parsing behind EnumProcessModules
+    (CreateProcessModulesFromMaps) with sample maps files.
+
+--*/
+
+#include "pal/dbgmsg.h"
+SET_DEFAULT_DEBUG_CHANNEL(PROCESS);
+
+#include "pal/procobj.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace CorUnix;
+
+#if !defined(__APPLE__) && HAVE_PROCFS_MAPS
+
+#include "testharness.h"
+
+static const ProcessModules *
+FindModule(const ProcessModules *listHead, const char *name)
+{
+    for (const ProcessModules *entry = listHead; entry != NULL; entry = entry->GetNext())
+    {
+        if (strcmp(entry->GetName(), name) == 0)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static ProcessModules *
+ParseMaps(const char *maps, DWORD *pCount)
+{
+    *pCount = (DWORD)-1;
+    return CreateProcessModulesFromMaps(maps, strlen(maps), pCount);
+}
+
+static void
+TestModules()
+{
+    const char *maps =
+        "35b1800000-35b1820000 r-xp 00000000 08:02 135522                     /usr/lib64/ld-2.15.so\n"
+        "35b1a1f000-35b1a20000 r--p 0001f000 08:02 135522                     /usr/lib64/ld-2.15.so\n"
+        "35b1a20000-35b1a21000 rw-p 00020000 08:02 135522                     /usr/lib64/ld-2.15.so\n"
+        "35b1a21000-35b1a22000 rw-p 00000000 00:00 0                          [heap]\n"
+        "35b1c00000-35b1dac000 r-xp 00000000 08:02 135870                     /usr/lib64/libc-2.15.so\n"
+        "35b1dac000-35b1fac000 ---p 001ac000 08:02 135870                     /usr/lib64/libc-2.15.so\n"
+        "7f0000000000-7f0000021000 rw-p 00000000 00:00 0 \n"
+        "7f0000100000-7f0000200000 rw-s 00000000 00:05 4711                   /dev/shm/doublemapper (deleted)\n"
+        "7f0000300000-7f0000310000 r--p 00000000 08:02 99                     /opt/My App/lib native.so\n"
+        "7f0000310000-7f0000320000 r-xp 00010000 08:02 99                     /opt/My App/lib native.so\n"
+        "7ffd00000000-7ffd00021000 rw-p 00000000 00:00 0                      [stack]\n"
+        "ffffffffff600000-ffffffffff601000 --xp 00000000 00:00 0              [vsyscall]\n";
+
+    DWORD count;
+    ProcessModules *listHead = ParseMaps(maps, &count);
+    CHECK(count == 4);
+
+    // Anonymous and pseudo mappings ([heap], [stack]) have no inode and aren't modules
+    CHECK(FindModule(listHead, "[heap]") == NULL);
+    CHECK(FindModule(listHead, "[stack]") == NULL);
+    CHECK(FindModule(listHead, "[vsyscall]") == NULL);
+
+    const ProcessModules *ld = FindModule(listHead, "/usr/lib64/ld-2.15.so");
+    CHECK(ld != NULL);
+    if (ld != NULL)
+    {
+        CHECK(ld->GetBaseAddress() == (PVOID)0x35b1800000);
+    }
+
+    const ProcessModules *libc = FindModule(listHead, "/usr/lib64/libc-2.15.so");
+    CHECK(libc != NULL);
+    if (libc != NULL)
+    {
+        CHECK(libc->GetBaseAddress() == (PVOID)0x35b1c00000);
+    }
+
+    // The " (deleted)" suffix is part of the name the kernel reports
+    CHECK(FindModule(listHead, "/dev/shm/doublemapper (deleted)") != NULL);
+
+    // Spaces in the path are kept and the mappings of one file are merged
+    const ProcessModules *native = FindModule(listHead, "/opt/My App/lib native.so");
+    CHECK(native != NULL);
+    if (native != NULL)
+    {
+        CHECK(native->GetBaseAddress() == (PVOID)0x7f0000300000);
+    }
+
+    // The list is in the reverse order the modules are first mapped
+    CHECK(listHead != NULL && strcmp(listHead->GetName(), "/opt/My App/lib native.so") == 0);
+
+    DestroyProcessModules(listHead);
+}
+
+static void
+TestBaseAddress()
+{
+    // The base address is the mapping at file offset 0 even when a later offset is mapped
+    // lower; without one the lowest mapping of the file is used.
+    const char *maps =
+        "7f1000000000-7f1000010000 r-xp 00010000 08:02 10   /usr/lib/liboffset.so\n"
+        "7f1000020000-7f1000030000 r--p 00000000 08:02 10   /usr/lib/liboffset.so\n"
+        "7f2000020000-7f2000030000 r--p 00002000 08:02 11   /usr/lib/libnoheader.so\n"
+        "7f2000010000-7f2000020000 r--p 00001000 08:02 11   /usr/lib/libnoheader.so";
+
+    DWORD count;
+    ProcessModules *listHead = ParseMaps(maps, &count);
+    CHECK(count == 2);
+
+    const ProcessModules *offset = FindModule(listHead, "/usr/lib/liboffset.so");
+    CHECK(offset != NULL);
+    if (offset != NULL)
+    {
+        CHECK(offset->GetBaseAddress() == (PVOID)0x7f1000020000);
+    }
+
+    // The last line has no newline
+    const ProcessModules *noHeader = FindModule(listHead, "/usr/lib/libnoheader.so");
+    CHECK(noHeader != NULL);
+    if (noHeader != NULL)
+    {
+        CHECK(noHeader->GetBaseAddress() == (PVOID)0x7f2000010000);
+    }
+
+    DestroyProcessModules(listHead);
+}
+
+static void
+TestMalformedLines()
+{
+    const char *maps =
+        "\n"
+        "garbage\n"
+        "7f3000000000 r-xp 00000000 08:02 12   /usr/lib/libnodash.so\n"
+        "7f3000000000-7f3000010000 r-xp 00000000 0802 12   /usr/lib/libnocolon.so\n"
+        "7f3000000000-7f3000010000 r-xp 00000000 08:02 12\n"
+        "7f3000000000-7f3000010000 r-xp 00000000 08:02 12   /usr/lib/libgood.so\n";
+
+    DWORD count;
+    ProcessModules *listHead = ParseMaps(maps, &count);
+    CHECK(count == 1);
+    CHECK(listHead != NULL && strcmp(listHead->GetName(), "/usr/lib/libgood.so") == 0);
+    DestroyProcessModules(listHead);
+
+    listHead = ParseMaps("", &count);
+    CHECK(count == 0);
+    CHECK(listHead == NULL);
+}
+
+static void
+TestManyModules()
+{
+    // Enough modules to grow the name hash table several times
+    const int moduleCount = 3000;
+    const int mappingsPerModule = 4;
+    char *maps = (char *)malloc(moduleCount * mappingsPerModule * 128);
+    CHECK(maps != NULL);
+    if (maps == NULL)
+    {
+        return;
+    }
+
+    size_t size = 0;
+    for (int mapping = 0; mapping < mappingsPerModule; mapping++)
+    {
+        for (int module = 0; module < moduleCount; module++)
+        {
+            unsigned long long start = 0x7f0000000000ull + ((unsigned long long)module * mappingsPerModule + mapping) * 0x1000;
+            size += sprintf(maps + size, "%llx-%llx r--p %08x 08:02 %d   /usr/lib/module%d.so\n",
+                start, start + 0x1000, mapping * 0x1000, module + 1, module);
+        }
+    }
+
+    DWORD count;
+    ProcessModules *listHead = CreateProcessModulesFromMaps(maps, size, &count);
+    CHECK(count == moduleCount);
+
+    int index = moduleCount;
+    for (const ProcessModules *entry = listHead; entry != NULL; entry = entry->GetNext())
+    {
+        char name[64];
+        index--;
+        sprintf(name, "/usr/lib/module%d.so", index);
+        CHECK(strcmp(entry->GetName(), name) == 0);
+        CHECK(entry->GetBaseAddress() == (PVOID)(0x7f0000000000ull + (unsigned long long)index * mappingsPerModule * 0x1000));
+    }
+    CHECK(index == 0);
+
+    DestroyProcessModules(listHead);
+    free(maps);
+}
+
+int
+main(int argc, char *argv[])
+{
+    TestModules();
+    TestBaseAddress();
+    TestMalformedLines();
+    TestManyModules();
+
+    return TestResult();
+}
+
+#else // !__APPLE__ && HAVE_PROCFS_MAPS
+
+int
+main(int argc, char *argv[])
+{
+    printf("SKIPPED: no /proc/<pid>/maps on this platform\n");
+    return 0;
+}
+
+#endif // !__APPLE__ && HAVE_PROCFS_MAPS
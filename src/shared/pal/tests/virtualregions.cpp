@@ -0,0 +1,149 @@
+// Licensed to the .NET Foundation under one or more agreements.
+// The .NET Foundation licenses this file to you under the MIT license.
+
+/*++
+
+Module Name:
+
+    tests/virtualregions.cpp
+
+Abstract:
+
+    Tests the sorted array of VirtualAlloc regions through VirtualAlloc, VirtualQuery
+    and VirtualFree: many regions are reserved, each is looked up from its first and
+    last page and they are released in a shuffled order. The time each step takes is
+    printed as a rough benchmark of the region lookups.
+
+--*/
+
+#include "pal/palinternal.h"
+#include "testharness.h"
+
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+struct Region
+{
+    BYTE *baseAddress;
+    SIZE_T size;
+    bool released;
+};
+
+static UINT32 s_random = 12345;
+
+static UINT32
+NextRandom()
+{
+    s_random = s_random * 1103515245 + 12345;
+    return s_random >> 8;
+}
+
+static void
+CheckRegion(const Region &region)
+{
+    MEMORY_BASIC_INFORMATION info;
+    const BYTE *addresses[] = { region.baseAddress, region.baseAddress + region.size - 1 };
+    for (const BYTE *address : addresses)
+    {
+        memset(&info, 0, sizeof(info));
+        CHECK(VirtualQuery(address, &info, sizeof(info)) == sizeof(info));
+        if (region.released)
+        {
+            CHECK(info.State != MEM_RESERVE && info.State != MEM_COMMIT);
+        }
+        else
+        {
+            // The PAL doesn't track the commits of a reservation; both are reported for the whole region
+            CHECK(info.State == MEM_RESERVE || info.State == MEM_COMMIT);
+            CHECK(info.RegionSize == region.size);
+        }
+    }
+}
+
+static long long
+ElapsedMilliseconds(std::chrono::steady_clock::time_point start)
+{
+    return (long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int
+main(int argc, char *argv[])
+{
+    if (PAL_InitializeDLL() != 0)
+    {
+        printf("FAILED: PAL_InitializeDLL\n");
+        return 1;
+    }
+
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    const SIZE_T pageSize = systemInfo.dwPageSize;
+    const int regionCount = 20000;
+    std::vector<Region> regions(regionCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < regionCount; i++)
+    {
+        Region &region = regions[i];
+        region.size = (1 + NextRandom() % 4) * pageSize;
+        region.released = false;
+        bool commit = (i % 2) != 0;
+        region.baseAddress = (BYTE *)VirtualAlloc(NULL, region.size, commit ? (MEM_RESERVE | MEM_COMMIT) : MEM_RESERVE, commit ? PAGE_READWRITE : PAGE_NOACCESS);
+        if (region.baseAddress == NULL)
+        {
+            printf("FAILED: VirtualAlloc %d\n", i);
+            return 1;
+        }
+        if (commit)
+        {
+            region.baseAddress[0] = 1;
+            region.baseAddress[region.size - 1] = 1;
+        }
+    }
+    printf("reserve %d regions: %lld ms\n", regionCount, ElapsedMilliseconds(start));
+
+    start = std::chrono::steady_clock::now();
+    for (const Region &region : regions)
+    {
+        CheckRegion(region);
+    }
+    printf("query %d regions: %lld ms\n", regionCount * 2, ElapsedMilliseconds(start));
+
+    // Release in a shuffled order checking the neighbours of each region released
+    std::vector<int> order(regionCount);
+    for (int i = 0; i < regionCount; i++)
+    {
+        order[i] = i;
+    }
+    for (int i = regionCount - 1; i > 0; i--)
+    {
+        std::swap(order[i], order[NextRandom() % (i + 1)]);
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < regionCount; i++)
+    {
+        Region &region = regions[order[i]];
+        CHECK(VirtualFree(region.baseAddress, 0, MEM_RELEASE));
+        region.released = true;
+
+        // The region can't be released twice
+        CHECK(!VirtualFree(region.baseAddress, 0, MEM_RELEASE));
+        CheckRegion(region);
+
+        if ((i % 1000) == 0)
+        {
+            for (const Region &other : regions)
+            {
+                if (!other.released)
+                {
+                    CheckRegion(other);
+                }
+            }
+        }
+    }
+    printf("release %d regions: %lld ms\n", regionCount, ElapsedMilliseconds(start));
+
+    return TestResult();
+}